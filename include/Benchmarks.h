@@ -0,0 +1,63 @@
+#pragma once
+
+namespace NetPhysics {
+
+	// Benchmarks run by the bot's -bench-* modes, none of them touch the globals of a running server or client
+
+	// Functions
+
+	/// <summary>Lays bodyCount resting bodies out row by row on a square grid.</summary>
+	/// <param name="bodyCount">Number of bodies</param>
+	/// <param name="x">Horizontal position of the first column</param>
+	/// <param name="y">Vertical position of the first row</param>
+	/// <param name="spacing">Distance between neighbouring columns and rows</param>
+	std::vector<TriangleData> BenchmarkGrid(int bodyCount, float x, float y, float spacing);
+
+	/// <summary>Creates a dynamic body with the shared triangle fixture, placed and moving as in state.</summary>
+	/// <param name="world">The world in which the body is instantiated</param>
+	/// <param name="state">Position, angle and velocities of the body</param>
+	/// <param name="density">Density of the fixture</param>
+	b2Body* CreateBenchmarkBody(b2World& world, const TriangleData& state, float density);
+
+	/// <summary>Steps a box of bodyCount falling triangles at 60 Hz.</summary>
+	/// <param name="bodyCount">Number of bodies</param>
+	/// <param name="ticks">Number of steps</param>
+	/// <param name="onTick">Gets every body's state after each step</param>
+	void SimulateBenchmarkScene(int bodyCount, int ticks, const std::function<void(std::span<const TriangleData>)>& onTick);
+
+	void BenchmarkProtocol(int iterations);
+
+	// Join of a client to a server holding bodyCount bodies over loopback, from the join request to the decoded keyframe
+	void BenchmarkJoin(int bodyCount);
+
+	/// <summary>Time the server takes to broadcast one snapshot to 100 to 5000 loopback clients, for 1 to 16 broadcast workers.</summary>
+	/// <param name="rounds">Broadcasts measured per client and worker count</param>
+	void BenchmarkBroadcast(int rounds);
+
+	void BenchmarkCompression();
+
+	// Bodies sent and extrapolation error seen by clients for a range of tolerances and broadcast intervals
+	void BenchmarkReckoning();
+
+	/// <summary>Time to step the default scene on 1 to 16 threads, the shard worlds being what is stepped in parallel.</summary>
+	/// <param name="ticks">Steps measured per thread count</param>
+	/// <param name="shardCount">Shards the arena is split into, 0 for one per thread</param>
+	void BenchmarkStep(int ticks, int shardCount);
+
+	/// <summary>Time to build the instance model matrices with linmath, the scalar kernel and the SSE2 kernel,
+	/// and the largest difference of each to linmath.</summary>
+	/// <param name="bodyCount">Matrices built per iteration</param>
+	/// <param name="iterations">Number of iterations measured</param>
+	void BenchmarkTransforms(int bodyCount, int iterations);
+
+	/// <summary>Spawn and despawn throughput of the pool against creating and destroying Box2D bodies.</summary>
+	/// <param name="batch">Bodies spawned and despawned per tick</param>
+	/// <param name="ticks">Number of ticks measured</param>
+	void BenchmarkBodyPool(int batch, int ticks);
+
+	/// <summary>Time to reset a settled pile of bodies to their starting grid and to step the tick after,
+	/// restoring body by body against the bulk restore.</summary>
+	/// <param name="bodyCount">Bodies in the pile</param>
+	/// <param name="rounds">Number of resets measured</param>
+	void BenchmarkReset(int bodyCount, int rounds);
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+namespace NetPhysics {
+
+	// Body pool globals
+
+	// Despawned bodies wait disabled at this height, below the visible arena, until their slot is reused
+	constexpr float BODY_PARKING_Y = -2.0f * ARENA_HALF_EXTENT;
+
+	// Bodies spawned or despawned per button press in the window
+	constexpr int BODY_SPAWN_BATCH = 10;
+
+	// Server side, despawned slots reused last in first out, only touched by the simulation thread
+	inline std::vector<int> FreeBodySlots;
+
+	// Requests from the render thread, applied at the start of the next tick
+	inline std::atomic<int> SpawnRequests;
+	inline std::atomic<int> DespawnRequests;
+
+	inline std::atomic<int> LiveBodyCount;
+
+	/// <summary>Returns the state every pooled body is sent with, at rest at the parking spot.</summary>
+	inline TriangleData ParkedBody() { return TriangleData { { 0, BODY_PARKING_Y, 0 }, { 0, 0, 0 } }; }
+
+	// Functions
+
+	/// <summary>Brings a pooled body back into the simulation with the given state.</summary>
+	/// <param name="body">Disabled body taken from the pool</param>
+	/// <param name="state">Pose and velocities to spawn with</param>
+	void RespawnBody(b2Body* body, const TriangleData& state);
+
+	/// <summary>Takes a body out of the simulation without destroying it, so it can be respawned later.</summary>
+	/// <param name="body">The body to park</param>
+	void ParkBody(b2Body* body);
+
+	/// <summary>Brings bodies of one world back to the given states. Every body is disabled first and then placed
+	/// and enabled again, so each costs one DestroyProxy and one CreateProxy through SetEnabled instead of a
+	/// proxy move per transform change. The broad-phase tree is not rebuilt.</summary>
+	/// <param name="bodies">Bodies of a single world</param>
+	/// <param name="states">State to restore for each body</param>
+	void RestoreBodies(std::span<b2Body* const> bodies, std::span<const TriangleData> states);
+
+	/// <summary>Marks the first liveCount slots live and parks every other body, which fills the pool.
+	/// Bodies that were never created, as on thin clients, only get their live bit.</summary>
+	/// <param name="liveCount">Number of bodies simulated from the start</param>
+	void InitBodyPool(int liveCount);
+
+	/// <summary>Spawns bodies into free slots until either the states or the slots run out.</summary>
+	/// <param name="states">State of each body to spawn</param>
+	/// <param name="slots">Receives the slot of each spawned body, at least as long as states</param>
+	/// <returns>Number of bodies spawned</returns>
+	int SpawnBodies(std::span<const TriangleData> states, std::span<int> slots);
+
+	/// <summary>Returns bodies to the pool, slots that are not live are ignored.</summary>
+	/// <param name="slots">Slots of the bodies to despawn</param>
+	/// <returns>Number of bodies despawned</returns>
+	int DespawnBodies(std::span<const int> slots);
+
+	/// <summary>Applies the spawn and despawn requests made since the last tick. Simulation thread only.</summary>
+	void ApplyBodyRequests();
+
+	/// <summary>Client side, enables and disables the local bodies whose slot changed liveness in a snapshot.
+	/// Must be called under TriDataMutex.</summary>
+	/// <param name="live">Live slots of the snapshot</param>
+	void ApplyBodyLiveness(const BodyMask& live);
+}
\ No newline at end of file
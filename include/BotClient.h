@@ -0,0 +1,57 @@
+#pragma once
+
+namespace NetPhysics {
+
+	struct BotConnection {
+		std::unique_ptr<ServerConnection> Server;
+
+		bool Connected = false;
+		uint64_t Snapshots = 0;
+		uint64_t Bytes = 0;
+		uint64_t MissedSnapshots = 0;
+		uint64_t BadSnapshots = 0;
+		uint64_t StaleSnapshots = 0;
+		uint32_t LastSequence = 0;
+
+		// Keyframes received and the time the last one took to reach a consistent state
+		uint64_t Keyframes = 0;
+		double SyncMs = 0.0;
+
+		// One-way delay from the server's send stamp, only meaningful when bots and server share a host
+		double LatencySumMs = 0.0;
+		double LatencyMaxMs = 0.0;
+	};
+
+	// Connections serviced by one bot thread
+	struct BotGroup {
+		std::mutex Mutex;
+		std::vector<BotConnection> Connections;
+		std::thread Thread;
+	};
+
+	struct BotTotals {
+		size_t Connected = 0;
+		uint64_t Snapshots = 0;
+		uint64_t Bytes = 0;
+		uint64_t MissedSnapshots = 0;
+		uint64_t BadSnapshots = 0;
+		uint64_t StaleSnapshots = 0;
+		uint64_t Keyframes = 0;
+		double LatencySumMs = 0.0;
+		double LatencyMaxMs = 0.0;
+		double SyncMaxMs = 0.0;
+	};
+
+	bool ValidateSnapshot(const SnapshotState& snapshot);
+
+	void ConsumeSnapshot(BotConnection& bot);
+
+	void BotGroupLoop(BotGroup& group, const RunningFlag& running);
+
+	BotTotals SumBotGroups(const std::vector<std::unique_ptr<BotGroup>>& groups);
+
+	bool WriteBotReport(const std::vector<std::unique_ptr<BotGroup>>& groups, const std::string& filename);
+
+	int RunBotClients(const RunningFlag& running, int count, int threads, int reportIntervalMs, const std::string& reportFile,
+		const wchar_t* address = L"127.0.0.1", const wchar_t* port = L"56789");
+}
\ No newline at end of file
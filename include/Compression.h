@@ -0,0 +1,74 @@
+#pragma once
+
+namespace NetPhysics {
+
+	// PacketHeader flag: the bytes after the message struct are a single zstd frame
+	constexpr uint8_t PACKET_FLAG_COMPRESSED = 1;
+
+	// Capability bits a client advertises in its join
+	constexpr uint8_t COMPRESSION_ZSTD = 1;
+	constexpr uint8_t COMPRESSION_DICTIONARY = 2;
+
+	constexpr int COMPRESSION_LEVEL = 3;
+	constexpr size_t COMPRESSION_DICTIONARY_BYTES = 32 * 1024;
+
+	enum class CompressionMode : uint8_t {
+		None,
+		Zstd,
+		ZstdDictionary,
+		Count
+	};
+
+	inline const char* const CompressionModeNames[] { "none", "zstd", "zstd+dict" };
+
+	struct ZstdDeleter {
+		void operator()(ZSTD_CCtx* context) const { ZSTD_freeCCtx(context); }
+		void operator()(ZSTD_DCtx* context) const { ZSTD_freeDCtx(context); }
+		void operator()(ZSTD_CDict* dictionary) const { ZSTD_freeCDict(dictionary); }
+		void operator()(ZSTD_DDict* dictionary) const { ZSTD_freeDDict(dictionary); }
+	};
+
+	// A trained dictionary digested for both directions, read-only and shared between threads once created
+	struct CompressionDictionary {
+		uint32_t Id = 0;
+		std::unique_ptr<ZSTD_CDict, ZstdDeleter> Compress;
+		std::unique_ptr<ZSTD_DDict, ZstdDeleter> Decompress;
+	};
+
+	// Set from the command line before any network thread starts
+
+	// Server side, compression is only used for clients that advertise it
+	inline bool CompressionEnabled = false;
+	inline std::unique_ptr<CompressionDictionary> SnapshotDictionary;
+
+	std::unique_ptr<CompressionDictionary> CreateCompressionDictionary(std::span<const std::byte> data);
+
+	bool LoadCompressionDictionary(const std::string& filename);
+
+	uint8_t CompressionCapabilities();
+
+	CompressionMode NegotiateCompression(uint8_t capabilities, uint32_t dictionaryId);
+
+	// Returns the frame size, 0 when the frame does not fit in out
+	size_t CompressPayload(std::span<const std::byte> payload, std::span<std::byte> out, const CompressionDictionary* dictionary);
+
+	// Returns the payload size, 0 for a corrupt frame, one that does not fit or one made with another dictionary
+	size_t DecompressPayload(std::span<const std::byte> frame, std::span<std::byte> out, const CompressionDictionary* dictionary);
+
+	// Replaces the rest of the reader, a compressed frame, with its payload decompressed into scratch
+	bool DecompressTrailing(ByteReader& reader, std::span<std::byte> scratch);
+
+	// Snapshot payloads recorded by the server as dictionary training samples
+
+	bool OpenSnapshotRecording(const std::string& filename);
+
+	void RecordSnapshotPayload(std::span<const std::byte> payload);
+
+	// Flushes and closes the recording, called once the broadcasts have stopped
+	void CloseSnapshotRecording();
+
+	// Returns the dictionary, empty when training failed
+	std::vector<std::byte> TrainDictionary(const std::vector<std::byte>& samples, const std::vector<size_t>& sizes);
+
+	bool TrainCompressionDictionary(const std::string& recordingFile, const std::string& dictionaryFile);
+}
\ No newline at end of file
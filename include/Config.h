@@ -0,0 +1,76 @@
+#pragma once
+
+namespace NetPhysics {
+
+	// Clients are only heard from when they acknowledge a broadcast, so at least four broadcasts must fit
+	// in CONNECTION_TIMEOUT_NS or a single lost one drops every client
+	constexpr int MAX_SEND_INTERVAL_MS = 1'250;
+
+	// Connection, tick and world parameters, read from a -config file and then overridden by flags of the same name
+	struct AppConfig {
+		// Address the server binds and clients connect to
+		std::string Address = "127.0.0.1";
+		int Port = 56789;
+
+		// Time between snapshot broadcasts, at most MAX_SEND_INTERVAL_MS
+		int SendIntervalMs = 1000;
+
+		// Bodies a server starts with live, the rest of the scene stays pooled
+		int Bodies = COUNT_TRIANGLES;
+
+		// Box2D solver iterations per step, clients that step their own world should use the server's values
+		int VelocityIterations = 20;
+		int PositionIterations = 10;
+
+		// Vertical gravity before the modifier set from the UI
+		float Gravity = -9.81f;
+
+		// Threads sending snapshots to the connected clients, each pinned to its own core after core 0
+		int BroadcastWorkers = static_cast<int>(std::max(1u, std::thread::hardware_concurrency() / 2));
+	};
+
+	inline AppConfig Config;
+
+	// Functions
+
+	/// <summary>Sets one configuration value, validating its format and range.</summary>
+	/// <param name="config">The configuration to change</param>
+	/// <param name="key">address, port, send-interval, bodies, velocity-iterations, position-iterations, gravity or broadcast-workers</param>
+	/// <param name="value">The value as written in the file or on the command line</param>
+	/// <param name="error">Receives what is wrong with the key or value</param>
+	/// <returns>Whether the value was set</returns>
+	bool SetConfigValue(AppConfig& config, std::string_view key, std::string_view value, std::string& error);
+
+	/// <summary>Reads a configuration file, one KEY VALUE pair per line. Everything after a # is a comment.
+	/// Errors are printed with their line number.</summary>
+	/// <param name="filename">Configuration file</param>
+	/// <param name="config">Receives the values set in the file</param>
+	/// <returns>Whether the whole file was valid</returns>
+	bool LoadConfigFile(const std::string& filename, AppConfig& config);
+
+	/// <summary>Applies a -KEY VALUE command line flag to the configuration.</summary>
+	/// <param name="i">Index of the flag, advanced past its value if it is a configuration flag</param>
+	/// <param name="argc">Argument count</param>
+	/// <param name="argv">Arguments</param>
+	/// <param name="config">The configuration to change</param>
+	/// <param name="valid">Cleared if the flag is a configuration flag with a missing or invalid value</param>
+	/// <returns>Whether the flag is a configuration flag</returns>
+	bool ParseConfigArgument(int& i, int argc, char* argv[], AppConfig& config, bool& valid);
+
+	/// <summary>Reads the integer value of a -FLAG VALUE argument that is not a configuration flag,
+	/// printing what is wrong with it.</summary>
+	/// <param name="i">Index of the flag, advanced past its value, which the caller checked is there</param>
+	/// <param name="argv">Arguments</param>
+	/// <param name="min">Smallest accepted value</param>
+	/// <param name="max">Largest accepted value</param>
+	/// <param name="value">Receives the value if it is valid</param>
+	/// <returns>Whether the value was set</returns>
+	bool ParseIntFlag(int& i, char* argv[], int min, int max, int& value);
+
+	/// <summary>Reads the number value of a -FLAG VALUE argument, see ParseIntFlag.</summary>
+	bool ParseFloatFlag(int& i, char* argv[], float min, float max, float& value);
+
+	std::wstring ConfigAddress(const AppConfig& config);
+
+	std::wstring ConfigPort(const AppConfig& config);
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+namespace NetPhysics {
+
+	// Distance from a body's origin to its farthest vertex, turns an angle error into a distance
+	constexpr float RECKONING_ANGLE_LEVER = 0.5f;
+
+	// Server side, a body is resent once the clients' extrapolation of it is off by more than this many
+	// meters. 0 sends every body that changed.
+	inline float ReckoningTolerance = 0;
+
+	// Client side, bodies are moved along their last received velocities instead of stepped by Box2D
+	inline bool ExtrapolationEnabled = false;
+
+	// Client side, the last received state of each body and the local tick it arrived at, guarded by TriDataMutex
+	inline TriangleData ReckonBase[COUNT_TRIANGLES];
+	inline uint32_t ReckonBaseTick[COUNT_TRIANGLES];
+
+	void ExtrapolateBody(TriangleData& body, float seconds);
+
+	// Position error plus the angle error at the farthest vertex, a bound on how far any vertex is off
+	float ReckoningError(const TriangleData& predicted, const TriangleData& actual);
+
+	// Advances the model, the states the clients extrapolate from, by seconds and returns the pending bodies
+	// whose actual state drifted past the tolerance. Pending is left holding the bodies that may still drift.
+	BodyMask SelectReckonedBodies(std::span<TriangleData> model, std::span<const TriangleData> actual, BodyMask& pending,
+		float seconds, float tolerance);
+
+	// Starts extrapolating from the current body poses at rest, until the first snapshot arrives
+	void SeedExtrapolation();
+
+	// Bodies whose state differs from their base were sent again and restart from tick
+	void RebaseExtrapolation(std::span<const TriangleData> bodies, uint32_t tick);
+
+	// Writes every body's pose extrapolated to tick
+	void ExtrapolateInstances(uint32_t tick, float* x, float* y, float* angle);
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+namespace NetPhysics {
+
+	// Frames the CPU may run ahead of the GPU when streaming instance data
+	constexpr int INSTANCE_STREAM_FRAMES = 3;
+
+	struct InstanceStream {
+		GLuint Buffer = 0;
+		GLsizeiptr FrameSize = 0;
+		int Frame = 0;
+
+		// Persistent streaming maps one ring buffer once and fences each frame's region,
+		// otherwise the buffer is orphaned and mapped again every frame
+		bool Persistent = false;
+		std::byte* Mapped = nullptr;
+		GLsync Fences[INSTANCE_STREAM_FRAMES] {};
+
+		// Written instead when mapping the orphaned buffer fails and uploaded with glBufferSubData
+		std::vector<std::byte> Staging;
+		bool Staged = false;
+
+		// Time the last BeginInstanceFrame spent waiting for the GPU, also recorded as the GpuWait profiler stage
+		double FenceWaitMs = 0.0;
+	};
+
+	// Functions
+
+	/// <summary>Creates the instance buffer, using persistently mapped storage when ARB_buffer_storage is present.</summary>
+	/// <param name="stream">The stream to initialize</param>
+	/// <param name="frameSize">Bytes of instance data written per frame</param>
+	void CreateInstanceStream(InstanceStream& stream, GLsizeiptr frameSize);
+
+	/// <summary>Unmaps and deletes the instance buffer and its fences.</summary>
+	/// <param name="stream">The stream to destroy</param>
+	void DestroyInstanceStream(InstanceStream& stream);
+
+	/// <summary>Returns mapped memory for this frame's instance data, waiting for the GPU if it still reads it.</summary>
+	/// <param name="stream">The stream to write</param>
+	void* BeginInstanceFrame(InstanceStream& stream);
+
+	/// <summary>Finishes writing this frame's instance data.</summary>
+	/// <param name="stream">The stream that was written</param>
+	/// <returns>Byte offset of this frame's data in the instance buffer</returns>
+	GLintptr EndInstanceFrame(InstanceStream& stream);
+
+	/// <summary>Fences this frame's region after the draw that reads it and advances to the next region.</summary>
+	/// <param name="stream">The stream that was drawn</param>
+	void FenceInstanceFrame(InstanceStream& stream);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+namespace NetPhysics {
+
+	using Job = std::function<void()>;
+
+	struct JobWorker {
+		std::mutex QueueMutex;
+		std::deque<Job> Queue;
+		std::thread Thread;
+	};
+
+	// Scheduler globals
+
+	inline std::vector<std::unique_ptr<JobWorker>> JobWorkers;
+
+	inline std::atomic<uint32_t> JobSignal;
+	inline std::atomic<unsigned> NextJobQueue;
+	inline std::atomic_flag JobsStopping;
+
+	// Functions
+
+	/// <summary>Starts the worker threads of the job scheduler.</summary>
+	/// <param name="count">Number of worker threads, not counting threads that wait on jobs</param>
+	void StartJobWorkers(unsigned count);
+
+	/// <summary>Stops and joins all job workers. Queued jobs are discarded.</summary>
+	void StopJobWorkers();
+
+	/// <summary>Queues a job on one of the worker queues.</summary>
+	/// <param name="job">The job to run</param>
+	void SubmitJob(Job job);
+
+	/// <summary>Runs one queued job, taking from the preferred queue first and stealing from the others.</summary>
+	/// <param name="preferred">Index of the queue to look in first</param>
+	/// <returns>Whether a job was run</returns>
+	bool TryRunJob(unsigned preferred);
+
+	/// <summary>Job worker thread loop.</summary>
+	/// <param name="index">Index of the worker's own queue</param>
+	void JobWorkerLoop(unsigned index);
+
+	/// <summary>Splits [0, count) into fixed chunks and runs them on the job workers. The calling thread
+	/// helps until all chunks are done. Chunk boundaries only depend on count and grain, so results that
+	/// are written per index are identical for any thread count.</summary>
+	/// <param name="count">Number of items</param>
+	/// <param name="grain">Items per chunk</param>
+	/// <param name="body">Called with the [begin, end) range of each chunk</param>
+	void ParallelFor(int count, int grain, const std::function<void(int, int)>& body);
+}
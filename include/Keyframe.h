@@ -0,0 +1,59 @@
+#pragma once
+
+namespace NetPhysics {
+
+	// Bodies per keyframe chunk, keeps every chunk datagram near 1200 bytes
+	constexpr uint16_t KEYFRAME_CHUNK_BODIES = 96;
+
+	// Quantization ranges, values are clamped to +-range and stored as int16. Positions cover twice the
+	// arena so bodies thrown past the walls still round trip, at a coarser step in larger worlds.
+	constexpr float KEYFRAME_POSITION_RANGE = std::max(64.0f, 2.0f * ARENA_HALF_EXTENT);
+	constexpr float KEYFRAME_VELOCITY_RANGE = 128.0f;
+
+	constexpr size_t MAX_KEYFRAME_CHUNK_PAYLOAD = WireSize<KeyframeMessage>() + 2 * ((KEYFRAME_CHUNK_BODIES + 7) / 8)
+		+ KEYFRAME_CHUNK_BODIES * (WireSize<QuantizedPose>() + WireSize<QuantizedVelocity>());
+
+	static_assert(MAX_KEYFRAME_CHUNK_PAYLOAD <= MAX_PACKET_PAYLOAD);
+
+	// Keyframe chunks as whole packets, encoded once and sent to every client that asks for one
+	struct EncodedKeyframe {
+		uint32_t Sequence = 0;
+		size_t Bytes = 0;
+		std::vector<std::vector<std::byte>> Chunks;
+	};
+
+	// Chunks of one keyframe collected until every body arrived
+	struct KeyframeAssembly {
+		uint32_t Sequence = 0;
+		int64_t SendTimeNs = 0;
+		float Gravity = 0;
+		uint64_t SceneHash = 0;
+		uint32_t InitialBodies = 0;
+		std::vector<TriangleData> Bodies;
+
+		// Live bit of each body, in 64-bit words like a BodyMask
+		std::vector<uint64_t> Live;
+		std::vector<bool> Received;
+		size_t Remaining = 0;
+	};
+
+	// Maps value in +-range onto the full int16 range, out of range values are clamped
+	int16_t QuantizeSigned(float value, float range);
+
+	float DequantizeSigned(int16_t value, float range);
+
+	QuantizedPose QuantizePose(const TriangleData& body);
+
+	QuantizedVelocity QuantizeVelocity(const TriangleData& body);
+
+	void DequantizeBody(const QuantizedPose& pose, const QuantizedVelocity& velocity, TriangleData& body);
+
+	// Live holds a bit per body in 64-bit words, empty when every body is live
+	std::shared_ptr<const EncodedKeyframe> EncodeKeyframe(uint32_t sequence, int64_t sendTimeNs, float gravity, uint64_t sceneHash,
+		uint32_t initialBodies, std::span<const TriangleData> bodies, std::span<const uint64_t> live = {});
+
+	// Returns false for a malformed chunk, a chunk of a newer keyframe restarts the assembly
+	bool AddKeyframeChunk(KeyframeAssembly& assembly, const KeyframeMessage& message, ByteReader& reader);
+
+	bool KeyframeComplete(const KeyframeAssembly& assembly);
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+
+namespace NetPhysics {
+
+	// Memory the rewind history may take, large worlds keep fewer ticks rather than growing past it
+	constexpr size_t REWIND_HISTORY_BUDGET = size_t { 64 } << 20;
+
+	// Ticks of body poses kept for rewinding, up to a little over two seconds to cover the snapshot interval
+	// plus round trip
+	constexpr uint32_t REWIND_HISTORY_TICKS = static_cast<uint32_t>(
+		std::clamp<size_t>(REWIND_HISTORY_BUDGET / (COUNT_TRIANGLES * 3 * sizeof(int16_t)), 8, 128));
+
+	// Recent broadcasts whose capture tick is remembered for resolving what a client was looking at
+	constexpr uint32_t SNAPSHOT_TICK_HISTORY = 64;
+
+	// Distance from a body's origin to its farthest vertex, only bodies this close to a query get the exact test
+	constexpr float INTERACTION_BOUND_RADIUS = 0.5f;
+
+	// Impulse per meter of mouse drag, the server clamps whatever a client sends to the maximum
+	constexpr float INTERACTION_IMPULSE_PER_METER = 10.0f;
+	constexpr float MAX_INTERACTION_IMPULSE = 50.0f;
+
+	// Queries per scheduler job
+	constexpr int INTERACTIONS_PER_JOB = 64;
+
+	// Body poses at the end of one tick, quantized like keyframe poses. Separate arrays let the
+	// query scan read positions only and look at the angle of the few bodies that are close. Pooled
+	// bodies all wait at the parking spot, so only the slots in Live can be hit.
+	struct RewindFrame {
+		uint32_t Tick = 0;
+		bool Valid = false;
+		BodyMask Live {};
+		int16_t X[COUNT_TRIANGLES];
+		int16_t Y[COUNT_TRIANGLES];
+		int16_t Angle[COUNT_TRIANGLES];
+	};
+
+	// A push at a world point, evaluated against the bodies as they were at Tick
+	struct InteractionQuery {
+		uint32_t Tick = 0;
+		float PointX = 0;
+		float PointY = 0;
+		float ImpulseX = 0;
+		float ImpulseY = 0;
+	};
+
+	// Body under the query point and the point in its local frame, Body is -1 for a miss
+	struct InteractionHit {
+		int Body = -1;
+		float LocalX = 0;
+		float LocalY = 0;
+	};
+
+	// Only the simulation thread records and queries the history
+	inline RewindFrame RewindHistory[REWIND_HISTORY_TICKS];
+
+	// Interactions from the network thread and the local window, applied at the start of the next tick
+	inline std::mutex InteractionsMutex;
+	inline std::vector<InteractionQuery> PendingInteractions;
+
+	// Capture tick of recent broadcasts, the sequence sits in the high half so a reused slot does not match
+	inline std::atomic<uint64_t> SnapshotTicks[SNAPSHOT_TICK_HISTORY];
+
+	// Client side, the snapshot last applied to the bodies and the local tick it was applied at
+	inline std::atomic<uint32_t> ViewSequence;
+	inline std::atomic<uint32_t> ViewTick;
+
+	// Client side, inputs from the render thread waiting for the connection thread to queue them
+	inline std::mutex OutgoingInputsMutex;
+	inline std::vector<InputMessage> OutgoingInputs;
+
+	inline void RecordSnapshotTick(const uint32_t sequence, const uint32_t tick) {
+		SnapshotTicks[sequence % SNAPSHOT_TICK_HISTORY].store(static_cast<uint64_t>(sequence) << 32 | tick, std::memory_order::relaxed);
+	}
+
+	// Returns false once the sequence has aged out of the table
+	inline bool FindSnapshotTick(const uint32_t sequence, uint32_t& tick) {
+		const uint64_t entry = SnapshotTicks[sequence % SNAPSHOT_TICK_HISTORY].load(std::memory_order::relaxed);
+		if (static_cast<uint32_t>(entry >> 32) != sequence) return false;
+
+		tick = static_cast<uint32_t>(entry);
+		return true;
+	}
+
+	inline void QueueInteraction(const InteractionQuery& query) {
+		Lock lock(InteractionsMutex);
+		PendingInteractions.push_back(query);
+	}
+
+	void ClearRewindHistory();
+
+	void RecordRewindFrame(uint32_t tick);
+
+	// The frame recorded at tick, ticks outside the history are clamped to the oldest or newest frame
+	const RewindFrame* FindRewindFrame(uint32_t tick);
+
+	bool QueryRewindFrame(const RewindFrame& frame, const InteractionQuery& query, InteractionHit& hit);
+
+	// Resolves every pending interaction against the history and applies the impulses to the live bodies
+	void ApplyPendingInteractions();
+
+	// A push from the local window, applied directly on a server and sent as input by a client
+	void SubmitInteraction(bool isServer, float pointX, float pointY, float impulseX, float impulseY);
+}
\ No newline at end of file
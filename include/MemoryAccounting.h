@@ -0,0 +1,39 @@
+#pragma once
+
+namespace NetPhysics {
+
+	// Memory globals
+
+	// Size classes of Box2D's small block allocator, which pools bodies, fixtures, shapes, proxies and contacts
+	constexpr size_t BOX2D_BLOCK_SIZES[] { 16, 32, 64, 96, 128, 160, 192, 224, 256, 320, 384, 448, 512, 640 };
+
+	// What a headless server may use in total, the report flags a build whose body count does not fit
+	constexpr size_t SERVER_MEMORY_BUDGET = size_t { 2 } << 30;
+
+	struct MemoryEntry {
+		const char* Subsystem;
+		size_t Bytes;
+	};
+
+	// Functions
+
+	/// <summary>Size of the block Box2D's allocator hands out for an allocation, larger ones go straight to the heap.</summary>
+	/// <param name="size">Requested size in bytes</param>
+	/// <returns>Bytes actually taken</returns>
+	constexpr size_t Box2DBlockBytes(const size_t size) {
+		for (const size_t block : BOX2D_BLOCK_SIZES) {
+			if (size <= block) return block;
+		}
+		return size;
+	}
+
+	/// <summary>Estimates the memory held by each subsystem from the live world and the static tables.
+	/// Must be called while no thread is stepping or resizing the worlds.</summary>
+	/// <param name="isServer">Whether the server side tables are in use</param>
+	/// <returns>One entry per subsystem</returns>
+	std::vector<MemoryEntry> AccountMemory(bool isServer);
+
+	/// <summary>Prints AccountMemory as bytes and bytes per body, with the total against SERVER_MEMORY_BUDGET.</summary>
+	/// <param name="isServer">Whether the server side tables are in use</param>
+	void PrintMemoryReport(bool isServer);
+}
\ No newline at end of file
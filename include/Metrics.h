@@ -0,0 +1,113 @@
+#pragma once
+
+namespace NetPhysics {
+
+	constexpr int METRIC_BUCKETS = 12;
+
+	struct MetricCounter {
+		const char* Name;
+		const char* Help;
+		std::atomic<uint64_t> Value;
+	};
+
+	struct MetricGauge {
+		const char* Name;
+		const char* Help;
+		std::atomic<int64_t> Value;
+	};
+
+	// Values are recorded as integers (nanoseconds, bytes) and multiplied by Scale on export
+	struct MetricHistogram {
+		const char* Name;
+		const char* Help;
+		double Scale;
+		std::array<uint64_t, METRIC_BUCKETS> Bounds;
+		std::atomic<uint64_t> Buckets[METRIC_BUCKETS + 1];
+		std::atomic<uint64_t> Count;
+		std::atomic<uint64_t> Sum;
+	};
+
+	constexpr std::array<uint64_t, METRIC_BUCKETS> DurationBoundsNs {
+		250'000, 500'000, 1'000'000, 2'000'000, 4'000'000, 8'000'000,
+		16'000'000, 33'000'000, 66'000'000, 133'000'000, 250'000'000, 1'000'000'000
+	};
+
+	constexpr std::array<uint64_t, METRIC_BUCKETS> SizeBoundsBytes {
+		64, 256, 1'024, 4'096, 16'384, 65'536,
+		262'144, 1'048'576, 4'194'304, 16'777'216, 67'108'864, 268'435'456
+	};
+
+	// Metric globals
+
+	inline MetricHistogram TickDurationMetric { "netphysics_tick_duration_seconds", "Duration of a simulation tick", 1e-9, DurationBoundsNs };
+	inline MetricHistogram BroadcastDurationMetric { "netphysics_broadcast_duration_seconds", "Duration of a snapshot broadcast to all clients", 1e-9, DurationBoundsNs };
+	inline MetricHistogram ClientSendBytesMetric { "netphysics_client_send_bytes", "Bytes sent to a single client per snapshot", 1.0, SizeBoundsBytes };
+	inline MetricHistogram ClientRttMetric { "netphysics_client_rtt_seconds", "Round trip from snapshot send to client ack", 1e-9, DurationBoundsNs };
+
+	inline MetricCounter BytesSentMetric { "netphysics_sent_bytes_total", "Bytes sent to all clients" };
+	inline MetricCounter SnapshotsMetric { "netphysics_snapshots_total", "Snapshots broadcast" };
+	inline MetricCounter KeyframesMetric { "netphysics_keyframes_total", "Full-state keyframes sent to joining or resyncing clients" };
+	inline MetricCounter InteractionsMetric { "netphysics_interactions_total", "Interaction queries evaluated against the rewind history" };
+	inline MetricCounter InteractionHitsMetric { "netphysics_interaction_hits_total", "Interaction queries that hit a body and applied an impulse" };
+	inline MetricCounter SendErrorsMetric { "netphysics_send_errors_total", "Client connections dropped after a send error" };
+
+	inline MetricGauge ClientsMetric { "netphysics_clients", "Connected clients" };
+	inline MetricGauge DirtyBodiesMetric { "netphysics_snapshot_dirty_bodies", "Bodies that changed in the last broadcast snapshot" };
+
+	inline MetricHistogram* const Histograms[] { &TickDurationMetric, &BroadcastDurationMetric, &ClientSendBytesMetric, &ClientRttMetric };
+	inline MetricCounter* const Counters[] { &BytesSentMetric, &SnapshotsMetric, &KeyframesMetric, &InteractionsMetric, &InteractionHitsMetric, &SendErrorsMetric };
+	inline MetricGauge* const Gauges[] { &ClientsMetric, &DirtyBodiesMetric };
+
+	// Functions
+
+	/// <summary>Adds to a counter. Lock-free, safe from any thread.</summary>
+	/// <param name="counter">The counter</param>
+	/// <param name="amount">Amount to add</param>
+	inline void AddMetric(MetricCounter& counter, const uint64_t amount = 1) {
+		counter.Value.fetch_add(amount, std::memory_order::relaxed);
+	}
+
+	/// <summary>Sets a gauge. Lock-free, safe from any thread.</summary>
+	/// <param name="gauge">The gauge</param>
+	/// <param name="value">The new value</param>
+	inline void SetMetric(MetricGauge& gauge, const int64_t value) {
+		gauge.Value.store(value, std::memory_order::relaxed);
+	}
+
+	/// <summary>Adds to a gauge. Lock-free, safe from any thread.</summary>
+	/// <param name="gauge">The gauge</param>
+	/// <param name="amount">Amount to add, may be negative</param>
+	inline void AddMetric(MetricGauge& gauge, const int64_t amount) {
+		gauge.Value.fetch_add(amount, std::memory_order::relaxed);
+	}
+
+	/// <summary>Records a value in a histogram. Lock-free, safe from any thread.</summary>
+	/// <param name="histogram">The histogram</param>
+	/// <param name="value">The value in the histogram's integer unit</param>
+	inline void ObserveMetric(MetricHistogram& histogram, const uint64_t value) {
+		size_t bucket = 0;
+		while (bucket < histogram.Bounds.size() && value > histogram.Bounds[bucket]) bucket++;
+
+		histogram.Buckets[bucket].fetch_add(1, std::memory_order::relaxed);
+		histogram.Count.fetch_add(1, std::memory_order::relaxed);
+		histogram.Sum.fetch_add(value, std::memory_order::relaxed);
+	}
+
+	/// <summary>Formats all metrics in the Prometheus text exposition format.</summary>
+	std::string FormatMetrics();
+
+	/// <summary>Writes the formatted metrics to a file, replacing it atomically.</summary>
+	/// <param name="filename">The file to write</param>
+	bool WriteMetricsFile(const std::string& filename);
+
+	/// <summary>Answers a single HTTP request on an accepted socket with the formatted metrics.</summary>
+	/// <param name="client">The accepted socket</param>
+	void ServeMetricsRequest(Socket client);
+
+	/// <summary>Exports metrics until the flag is set, over HTTP on localhost and/or to a file.</summary>
+	/// <param name="running">Flag that stops the exporter when set</param>
+	/// <param name="port">Local HTTP port, or empty to disable the listener</param>
+	/// <param name="filename">File rewritten every interval, or empty to disable</param>
+	/// <param name="intervalMs">Interval between file writes</param>
+	int RunMetricsExporter(const RunningFlag& running, std::wstring port, std::string filename, int intervalMs);
+}
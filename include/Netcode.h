@@ -2,9 +2,105 @@
 
 namespace NetPhysics {
 
-	inline std::vector<std::future<int>> SendOperations;
+	// Peers that have not been heard from for this long are dropped
+	constexpr int64_t CONNECTION_TIMEOUT_NS = 5'000'000'000;
 
-	inline std::vector<Socket> Clients;
+	// Clients repeat their join until a whole keyframe arrives
+	constexpr int64_t JOIN_INTERVAL_NS = 250'000'000;
+
+	// Keyframe chunks sent to a joining client per worker iteration, which run about 1 ms apart while a keyframe
+	// is in flight, so a join of a large world never floods the socket buffer
+	constexpr size_t KEYFRAME_CHUNKS_PER_SERVICE = 64;
+
+	struct SnapshotState {
+		uint32_t Sequence = 0;
+		int64_t SendTimeNs = 0;
+		TriangleData Bodies[COUNT_TRIANGLES];
+		BodyMask Live {};
+	};
+
+	// Server side of a client connection
+	struct ClientConnection {
+		sockaddr_in Address {};
+		int64_t LastHeardNs = 0;
+
+		// Set by a join, the client gets no deltas until it was sent a keyframe
+		bool NeedsKeyframe = true;
+
+		// Keyframe being sent in paced batches and its next chunk, restarted when a newer broadcast overtakes it
+		std::shared_ptr<const EncodedKeyframe> Keyframe;
+		size_t KeyframeChunk = 0;
+
+		// Negotiated from the capabilities in the client's join
+		CompressionMode Compression = CompressionMode::None;
+
+		ReliableChannel Channel;
+
+		NetworkShim Outbound;
+		NetworkShim Inbound;
+	};
+
+	// Client side of the server connection, sized by the body count and always heap allocated
+	struct ServerConnection {
+		Socket Handle = INVALID_SOCKET;
+		std::array<std::byte, MAX_PACKET_SIZE> Buffer;
+		std::array<std::byte, MAX_SNAPSHOT_PAYLOAD> Decompressed;
+		SnapshotAssembly Assembly;
+
+		// Newest state handed out by PollServerConnection, deltas are only applied on top of LastSequence
+		SnapshotState Latest;
+		uint32_t LastSequence = 0;
+		bool Synced = false;
+
+		// Bodies the server starts with live, sent with the keyframe
+		int InitialBodies = 0;
+
+		// Snapshots and deltas are decoded here and only copied to Latest once the whole payload is valid
+		SnapshotState Pending;
+
+		KeyframeAssembly Keyframe;
+		uint64_t Keyframes = 0;
+
+		int64_t LastHeardNs = 0;
+		int64_t LastJoinNs = 0;
+
+		// Time to consistent state, from the first join sent while out of sync to the keyframe completing
+		int64_t JoinStartNs = 0;
+		int64_t SyncDurationNs = 0;
+
+		// Snapshots dropped because a newer one was already delivered
+		uint64_t StaleSnapshots = 0;
+		uint64_t BytesReceived = 0;
+
+		ReliableChannel Channel;
+
+		NetworkShim Outbound;
+		NetworkShim Inbound;
+	};
+
+	// Broadcast worker pool
+
+	struct BroadcastShard {
+		std::mutex ClientsMutex;
+		std::unordered_map<uint64_t, ClientConnection> Clients;
+		std::thread Worker;
+
+		// Bumped for every snapshot and whenever clients have new reliable messages queued
+		std::atomic<uint32_t> Wake;
+	};
+
+	inline std::vector<std::unique_ptr<BroadcastShard>> BroadcastShards;
+
+	inline std::atomic<uint64_t> SnapshotGeneration;
+	inline std::atomic<int> ShardsPending;
+	inline std::atomic_flag BroadcastStopping;
+
+	// UDP socket shared by the listener, which receives, and the broadcast workers, which send
+	inline Socket ServerSocket = INVALID_SOCKET;
+
+	// Shard owning each client address, taken after a shard's ClientsMutex and never the other way round
+	inline std::mutex ClientIndexMutex;
+	inline std::unordered_map<uint64_t, BroadcastShard*> ClientIndex;
 
 	int WSAInit();
 
@@ -26,11 +122,85 @@ namespace NetPhysics {
 
 	Socket CreateStreamSocket();
 
-	int SendDataToClient(Socket client);
+	Socket CreateDatagramSocket();
+
+	uint64_t AddressKey(const sockaddr_in& address);
+
+	Socket OpenServerConnection(const wchar_t* address = L"127.0.0.1", const wchar_t* port = L"56789");
+
+	int64_t NetworkTimeNs();
+
+	int SendBytes(Socket s, const char* data, size_t size);
+
+	int ReceiveDatagram(Socket s, std::span<std::byte> buffer);
+
+	int FlushShimToSocket(Socket s, NetworkShim& shim, int64_t nowNs);
+
+	int SendToServer(ServerConnection& server, std::span<const std::byte> packet);
+
+	int SendChannelAck(ServerConnection& server, int64_t echoTimeNs);
+
+	int SendJoin(ServerConnection& server, int64_t nowNs);
+
+	int CompleteKeyframe(ServerConnection& server);
+
+	void ApplyControlPacket(std::span<const std::byte> packet);
+
+	int HandleServerPacket(ServerConnection& server, std::span<const std::byte> packet);
+
+	int PollServerConnection(ServerConnection& server);
+
+	void QueueOutgoingInputs(ServerConnection& server);
+
+	void RecordAck(const AckMessage& ack);
+
+	int SendToClient(ClientConnection& client, std::span<const std::byte> packet);
+
+	void ApplyClientInput(std::span<const std::byte> packet);
+
+	void HandleClientPacket(ClientConnection& client, std::span<const std::byte> packet);
+
+	void HandleDatagram(const sockaddr_in& from, std::span<const std::byte> packet);
+
+	void ApplySnapshot(const SnapshotState& snapshot);
+
+	int SendSnapshotToClient(ClientConnection& client);
+
+	std::shared_ptr<const EncodedKeyframe> CurrentKeyframe();
+
+	void SendKeyframeToClient(ClientConnection& client);
+
+	bool ServiceClient(ClientConnection& client, int64_t nowNs);
+
+	bool ShardNeedsService(BroadcastShard& shard);
+
+	void WakeBroadcastWorkers();
+
+	void PinThreadToCore(unsigned core);
+
+	void BroadcastWorker(BroadcastShard& shard, unsigned core);
+
+	void StartBroadcastWorkers(unsigned count);
+
+	void StopBroadcastWorkers();
+
+	BroadcastShard* FindClientShard(uint64_t key);
+
+	BroadcastShard* AddClient(const sockaddr_in& address);
+
+	size_t ClientCount();
+
+	void QueueReliableBroadcast(std::span<const std::byte> packet);
+
+	template <WireMessage T>
+	void SendReliableToClients(const T& message) {
+		std::array<std::byte, PACKET_HEADER_SIZE + WireSize<T>()> packet;
+		QueueReliableBroadcast(std::span(packet).first(EncodePacket(message, packet)));
+	}
 
 	int BroadcastTriangleData();
 
-	void TimedSend(long long ns, const RunningFlag& flag);
+	void TimedSend(int64_t intervalNs, const RunningFlag& flag);
 
 	int ListenForClients(const RunningFlag& running);
 
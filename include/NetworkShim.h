@@ -0,0 +1,69 @@
+#pragma once
+
+namespace NetPhysics {
+
+	enum class ShimDirection : uint8_t {
+		Outbound,
+		Inbound,
+		Count
+	};
+
+	constexpr const char* ShimDirectionNames[] = { "Outbound", "Inbound" };
+
+	static_assert(std::size(ShimDirectionNames) == static_cast<size_t>(ShimDirection::Count));
+
+	struct NetworkConditions {
+		float DelayMs = 0.0f;
+		float JitterMs = 0.0f;
+		float LossPercent = 0.0f;
+		float DuplicatePercent = 0.0f;
+
+		// Share of messages that skip the delay and overtake the ones already queued
+		float ReorderPercent = 0.0f;
+
+		// Zero leaves the link unlimited
+		int BandwidthKbps = 0;
+	};
+
+	struct ShimMessage {
+		int64_t ReleaseNs;
+		std::vector<char> Data;
+	};
+
+	// One per connection and direction, Queue is kept sorted by release time
+	struct NetworkShim {
+		std::minstd_rand Random;
+		std::deque<ShimMessage> Queue;
+		int64_t LinkFreeNs = 0;
+	};
+
+	// Network shim globals
+
+	inline std::mutex NetworkConditionsMutex;
+	inline NetworkConditions ShimConditions[static_cast<size_t>(ShimDirection::Count)];
+
+	// Cleared while every condition is zero so the transport can bypass the shim entirely
+	inline std::atomic<bool> NetworkShimEnabled;
+
+	inline std::atomic<uint32_t> NetworkShimSeed { 1 };
+
+	bool ConditionsActive(const NetworkConditions& conditions);
+
+	void SetNetworkConditions(ShimDirection direction, const NetworkConditions& conditions);
+
+	NetworkConditions GetNetworkConditions(ShimDirection direction);
+
+	void SeedNetworkShim(NetworkShim& shim, uint32_t stream);
+
+	bool ShimActive(const NetworkShim& shim);
+
+	void ShimSubmit(NetworkShim& shim, ShimDirection direction, const char* data, size_t size, int64_t nowNs);
+
+	const ShimMessage* ShimPeek(const NetworkShim& shim, int64_t nowNs);
+
+	void ShimPop(NetworkShim& shim);
+
+	bool ParseNetworkShimArgument(int& i, int argc, char* argv[]);
+
+	void DrawNetworkShimWindow();
+}
\ No newline at end of file
@@ -7,11 +7,20 @@ namespace NetPhysics {
 		vec3 PhysicsData;
 	};
 
+	// Per-instance data uploaded for drawing: a 64 byte model matrix or a 12 byte x, y, angle pose
+	enum class InstanceLayout {
+		Compact,
+		Matrix
+	};
+
 	struct Vertex {
 		vec2 Position;
 		vec3 Color;
 	};
 
+	struct InstanceStream;
+	struct SceneMaterial;
+
 	// Triangle drawing data
 
 	constexpr Vertex TriangleVertices[3] = {
@@ -24,28 +33,81 @@ namespace NetPhysics {
 
 	// World globals
 
-	constexpr int COUNT_TRIANGLES = 100;
-	inline b2Body* Walls[4u];
+	// Set by the NETPHYSICS_BODY_COUNT cache variable, every body table is sized from it at compile time
+#ifndef NETPHYSICS_BODY_COUNT
+#define NETPHYSICS_BODY_COUNT 100
+#endif
+
+	constexpr int COUNT_TRIANGLES = NETPHYSICS_BODY_COUNT;
+
+	static_assert(COUNT_TRIANGLES > 0);
+
+	// Bodies start on a square grid one meter apart, the arena grows with the grid
+	constexpr int BODY_GRID_COLUMNS = [] {
+		int columns = 1;
+		while (columns * columns < COUNT_TRIANGLES) columns++;
+		return columns;
+	}();
+
+	constexpr float ARENA_HALF_EXTENT = std::max(7.0f, static_cast<float>(BODY_GRID_COLUMNS / 2 + 2));
+
+	// Bodies handled per scheduler job in per-body loops
+	constexpr int BODIES_PER_JOB = 1024;
+
+	// One bit per body, in 64-bit words so jobs over 64-aligned ranges never share a word
+	using BodyMask = std::array<uint64_t, (COUNT_TRIANGLES + 63) / 64>;
+
+	static_assert(BODIES_PER_JOB % 64 == 0);
+
+	// Mask with the bit of every body slot set
+	constexpr BodyMask ALL_BODIES = [] {
+		BodyMask mask {};
+		mask.fill(~uint64_t { 0 });
+		if (COUNT_TRIANGLES % 64 != 0) mask.back() = (uint64_t { 1 } << (COUNT_TRIANGLES % 64)) - 1;
+		return mask;
+	}();
 
 	inline std::atomic_flag ObjectsInitialized;
 
 	inline b2Body* Triangles[COUNT_TRIANGLES];
-	inline mat4x4 TriangleTransforms[COUNT_TRIANGLES];
 
 	inline std::mutex TriDataMutex;
 	inline TriangleData TriData[COUNT_TRIANGLES];
 
-	// Functions
+	// Bodies whose TriData changed since the last broadcast, guarded by TriDataMutex
+	inline BodyMask TriDataDirty;
 
-	/// <summary>Creates walls around the scene with physics objects.</summary>
-	///	<param name="world">The world in which the objects are instantiated</param>
-	void CreateWorldBounds(const std::unique_ptr<b2World>& world);
+	// Simulation tick of the last capture into TriData, guarded by TriDataMutex
+	inline uint32_t TriDataTick;
 
-	/// <summary>Creates triangular physics bodies into the world.</summary>
-	/// <param name="world">The world in which the triangles are instantiated</param>
-	void CreatePhysicsTriangles(const std::unique_ptr<b2World>& world);
+	// Bodies that were awake at the last capture
+	inline BodyMask TrianglesAwake;
 
-	/// <summary>Resets the simulation to its starting state.</summary>
+	// Slots holding a simulated body, the others wait disabled in the body pool. Written by the simulation
+	// thread, and on clients by the network thread under TriDataMutex.
+	inline BodyMask BodiesLive;
+
+	// BodiesLive as of the last capture into TriData, guarded by TriDataMutex
+	inline BodyMask TriDataLive;
+
+	// Set when TriData was restored to the initial state, the next broadcast tells clients to do the same.
+	// Guarded by TriDataMutex.
+	inline bool TriDataReset;
+
+	// State every body starts in and returns to on a reset, captured from the active scene with the first
+	// InitialBodyCount bodies live. Pooled slots hold the parked state. Clients start with every scene body live
+	// and take the server's count from the keyframe for the baseline of a reset delta.
+	inline TriangleData InitialTriData[COUNT_TRIANGLES];
+	inline BodyMask InitialLive;
+	inline int InitialBodyCount;
+
+	// Functions
+
+	/// <summary>Captures the active scene into InitialTriData and InitialLive.</summary>
+	/// <param name="liveCount">Bodies live from the start, the rest of the scene stays pooled</param>
+	void CaptureInitialState(int liveCount);
+
+	/// <summary>Restores every body to the captured initial state, shard by shard on the job workers.</summary>
 	void ResetSimulation();
 
 	/// <summary>Key callback for GLFW.</summary>
@@ -76,13 +138,68 @@ namespace NetPhysics {
 	/// <param name="name">The name of the shader to generate. Used in filename</param>
 	GLuint GenerateShaderProgram(const std::string& name);
 
+	/// <summary>Generates a shader program from separately named vertex and fragment shaders, loaded from the
+	/// shader cache when the sources and driver are unchanged.</summary>
+	/// <param name="vertexName">The name of the vertex shader. Used in filename</param>
+	/// <param name="fragmentName">The name of the fragment shader. Used in filename</param>
+	GLuint GenerateShaderProgram(const std::string& vertexName, const std::string& fragmentName);
+
+	/// <summary>Points the per-instance attributes at instance data in the bound array buffer.</summary>
+	/// <param name="program">The shader program for triangles</param>
+	/// <param name="layout">Layout of the per-instance data</param>
+	/// <param name="offset">Byte offset of the first instance in the buffer</param>
+	void SetInstanceAttributes(const GLuint& program, InstanceLayout layout, GLintptr offset);
+
 	/// <summary>Generates GPU buffers for drawing triangles.</summary>
 	/// <param name="program">The shader program for triangles</param>
 	/// <param name="vertexBuffer">The vertex buffer</param>
-	/// <param name="transformBuffer">The transform buffer</param>
 	/// <param name="indexBuffer">The index buffer</param>
 	/// <param name="vertexArray">The vertex array</param>
-	void GenerateTriangleBuffers(const GLuint& program, GLuint& vertexBuffer, GLuint& transformBuffer, GLuint& indexBuffer, GLuint& vertexArray);
-
-	void CollectTriangleData();
+	/// <param name="instances">The stream that provides per-instance data</param>
+	/// <param name="layout">Layout of the per-instance data</param>
+	void GenerateTriangleBuffers(const GLuint& program, GLuint& vertexBuffer, GLuint& indexBuffer, GLuint& vertexArray,
+		const InstanceStream& instances, InstanceLayout layout = InstanceLayout::Compact);
+
+	/// <summary>Returns the size of the per-instance data of all triangles in the given layout.</summary>
+	/// <param name="layout">The instance layout</param>
+	size_t InstanceDataSize(InstanceLayout layout);
+
+	/// <summary>Sets the bit of a body in a body mask.</summary>
+	/// <param name="mask">The mask to modify</param>
+	/// <param name="index">Index of the body</param>
+	inline void SetBodyBit(BodyMask& mask, const int index) { mask[index >> 6] |= uint64_t { 1 } << (index & 63); }
+
+	/// <summary>Clears the bit of a body in a body mask.</summary>
+	/// <param name="mask">The mask to modify</param>
+	/// <param name="index">Index of the body</param>
+	inline void ClearBodyBit(BodyMask& mask, const int index) { mask[index >> 6] &= ~(uint64_t { 1 } << (index & 63)); }
+
+	/// <summary>Tests the bit of a body in a body mask.</summary>
+	/// <param name="mask">The mask to test</param>
+	/// <param name="index">Index of the body</param>
+	inline bool TestBodyBit(const BodyMask& mask, const int index) { return (mask[index >> 6] >> (index & 63)) & 1u; }
+
+	/// <summary>Calls a function for every body whose bit is set in a body mask.</summary>
+	/// <param name="mask">The mask to iterate</param>
+	/// <param name="func">Called with the index of each set body</param>
+	template <typename Func>
+	void ForEachBodyBit(const BodyMask& mask, Func&& func) {
+		for (size_t word = 0; word < mask.size(); word++) {
+			for (uint64_t bits = mask[word]; bits != 0; bits &= bits - 1) {
+				func(static_cast<int>(word * 64 + std::countr_zero(bits)));
+			}
+		}
+	}
+
+	/// <summary>Forces every body to be captured on the next CollectTriangleData, even if asleep.</summary>
+	void MarkAllTrianglesChanged();
+
+	/// <summary>Restores TriData to the captured initial state and flags the next broadcast as a reset, so only
+	/// bodies that leave the initial state are sent again.</summary>
+	void ResetTriangleData();
+
+	/// <summary>Copies the state of awake or changed bodies into TriData for sending and marks them
+	/// in TriDataDirty. Bodies that stayed asleep since the last capture are skipped.</summary>
+	/// <param name="tick">Simulation tick the bodies are at, stored in TriDataTick</param>
+	void CollectTriangleData(uint32_t tick);
 }
\ No newline at end of file
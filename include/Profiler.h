@@ -0,0 +1,152 @@
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define NETPHYSICS_PROFILE_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define NETPHYSICS_PROFILE_TSC 1
+#endif
+
+namespace NetPhysics {
+
+	enum class ProfileStage : uint8_t {
+		Frame,
+		Tick,
+		Step,
+		Capture,
+		Rewind,
+		Transforms,
+		Upload,
+		GpuWait,
+		Broadcast,
+		Compress,
+		Receive,
+		Keyframe,
+		Count
+	};
+
+	constexpr const char* ProfileStageNames[] = {
+		"Frame", "Tick", "Step", "Capture", "Rewind", "Transforms", "Upload", "GpuWait", "Broadcast", "Compress", "Receive", "Keyframe"
+	};
+
+	static_assert(std::size(ProfileStageNames) == static_cast<size_t>(ProfileStage::Count));
+
+	// Histogram buckets are powers of two nanoseconds, bucket 31 collects everything above ~1 s
+	constexpr int PROFILE_HISTOGRAM_BUCKETS = 32;
+
+	// Recent sample durations kept per stage for the timeline plot
+	constexpr int PROFILE_HISTORY = 128;
+
+	// Trace events kept per thread, older events are overwritten
+	constexpr size_t TRACE_CAPACITY = size_t { 1 } << 14;
+
+	struct StageStats {
+		std::atomic<uint64_t> Count;
+		std::atomic<uint64_t> TotalNs;
+		std::atomic<uint64_t> MaxNs;
+		std::atomic<uint32_t> Buckets[PROFILE_HISTOGRAM_BUCKETS];
+		std::atomic<float> HistoryUs[PROFILE_HISTORY];
+	};
+
+	struct TraceEvent {
+		int64_t StartTicks;
+		int64_t EndTicks;
+		ProfileStage Stage;
+	};
+
+	struct TraceBuffer {
+		uint32_t ThreadId = 0;
+		std::atomic<uint64_t> Head;
+		TraceEvent Events[TRACE_CAPACITY];
+	};
+
+	// One step of process startup, in nanoseconds since StartupClockOrigin
+	struct StartupPhase {
+		const char* Name;
+		int64_t StartNs;
+		int64_t EndNs;
+	};
+
+	// Profiler globals
+
+	inline StageStats ProfileStats[static_cast<size_t>(ProfileStage::Count)];
+
+	inline std::atomic_flag TraceEnabled;
+	inline std::mutex TraceBuffersMutex;
+	inline std::vector<std::unique_ptr<TraceBuffer>> TraceBuffers;
+
+	// Taken during static initialization, so the timeline leaves out only the loader's work before it
+	inline const std::chrono::steady_clock::time_point StartupClockOrigin = std::chrono::steady_clock::now();
+
+	inline std::mutex StartupPhasesMutex;
+	inline std::vector<StartupPhase> StartupPhases;
+
+	// Functions
+
+	/// <summary>Returns the profiler clock in ticks. Uses the time stamp counter where available, which is
+	/// cheaper to read than the OS clock.</summary>
+	inline int64_t ProfileTicks() {
+#ifdef NETPHYSICS_PROFILE_TSC
+		return static_cast<int64_t>(__rdtsc());
+#else
+		return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+	}
+
+	/// <summary>Measures the length of a profiler tick against the steady clock.</summary>
+	double CalibrateProfileTicks();
+
+	inline const double ProfileNsPerTick = CalibrateProfileTicks();
+
+	/// <summary>Adds a timed sample to its stage's statistics and, while tracing, to the thread's trace buffer.</summary>
+	/// <param name="stage">The stage that was timed</param>
+	/// <param name="startTicks">Start of the sample</param>
+	/// <param name="endTicks">End of the sample</param>
+	void RecordProfileSample(ProfileStage stage, int64_t startTicks, int64_t endTicks);
+
+	/// <summary>Returns the calling thread's trace buffer, creating it on first use.</summary>
+	TraceBuffer& ThreadTraceBuffer();
+
+	/// <summary>Returns the duration below which the given fraction of a stage's samples fall.</summary>
+	/// <param name="stage">The stage to query</param>
+	/// <param name="fraction">Fraction of samples, e.g. 0.99</param>
+	double ProfilePercentileUs(ProfileStage stage, double fraction);
+
+	/// <summary>Clears all statistics and trace buffers.</summary>
+	void ResetProfiler();
+
+	/// <summary>Writes recorded trace events as Chrome trace event JSON, viewable in chrome://tracing or Perfetto.</summary>
+	/// <param name="filename">The file to write</param>
+	/// <returns>Whether the file was written</returns>
+	bool WriteChromeTrace(const std::string& filename);
+
+	/// <summary>Returns the nanoseconds since StartupClockOrigin.</summary>
+	int64_t StartupElapsedNs();
+
+	/// <summary>Records a startup phase that began at startNs and ends now.</summary>
+	/// <param name="name">Name of the phase, a string literal</param>
+	/// <param name="startNs">Start of the phase from StartupElapsedNs</param>
+	/// <returns>The end of the phase, to start the next one from</returns>
+	int64_t EndStartupPhase(const char* name, int64_t startNs);
+
+	/// <summary>Prints every recorded startup phase in start order with its offset and duration.</summary>
+	void PrintStartupTimeline();
+
+	/// <summary>Draws the profiler panel with per-stage statistics, timelines and histograms.</summary>
+	void DrawProfilerWindow();
+
+	/// <summary>Times the enclosing scope into a profiler stage.</summary>
+	struct ProfileScope {
+		const ProfileStage Stage;
+		const int64_t StartTicks;
+
+		explicit ProfileScope(const ProfileStage stage) : Stage(stage), StartTicks(ProfileTicks()) {}
+		~ProfileScope() { RecordProfileSample(Stage, StartTicks, ProfileTicks()); }
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+	};
+}
+
+#define PROFILE_SCOPE(stage) const NetPhysics::ProfileScope profileScope { NetPhysics::ProfileStage::stage }
@@ -0,0 +1,437 @@
+#pragma once
+
+namespace NetPhysics {
+
+	// Bump on any change to a message layout, peers with a different version are disconnected
+	constexpr uint32_t PROTOCOL_MAGIC = 0x5948504E; // "NPHY"
+	constexpr uint16_t PROTOCOL_VERSION = 10;
+
+	enum class MessageType : uint8_t {
+		Snapshot,
+		Delta,
+		Ack,
+		Input,
+		Ping,
+		Gravity,
+		Reliable,
+		Join,
+		Keyframe,
+		Count
+	};
+
+	struct PacketHeader {
+		uint32_t Magic;
+		uint16_t Version;
+		MessageType Type;
+		uint8_t Flags;
+
+		// Payload bytes following the header
+		uint32_t Size;
+	};
+
+	// PacketHeader flag on a delta: the changes apply on top of the scene's initial state instead of the baseline,
+	// which is how a reset reaches the clients
+	constexpr uint8_t PACKET_FLAG_RESET = 2;
+
+	// Reliable channel acknowledgement: everything before Next was received, bit i of Bits marks Next + 1 + i
+	struct ChannelAck {
+		uint16_t Next;
+		uint32_t Bits;
+	};
+
+	// The payload is EventCount BodyEvent entries despawning every pooled slot, then BodyCount TriangleData entries.
+	// It is split into ChunkCount packets of SNAPSHOT_CHUNK_BYTES, each repeating the message with its ChunkIndex.
+	struct SnapshotMessage {
+		static constexpr MessageType Type = MessageType::Snapshot;
+		uint32_t Sequence;
+		int64_t SendTimeNs;
+		uint32_t BodyCount;
+		uint32_t EventCount;
+		ChannelAck Channel;
+		uint16_t ChunkIndex;
+		uint16_t ChunkCount;
+	};
+
+	// The payload is EventCount BodyEvent entries for the slots spawned or despawned since the BaselineSequence
+	// snapshot, then ChangedCount BodyDelta entries relative to it, or relative to the initial state with PACKET_FLAG_RESET.
+	// Chunked like a snapshot.
+	struct DeltaMessage {
+		static constexpr MessageType Type = MessageType::Delta;
+		uint32_t Sequence;
+		uint32_t BaselineSequence;
+		int64_t SendTimeNs;
+		uint32_t BodyCount;
+		uint32_t EventCount;
+		uint32_t ChangedCount;
+		ChannelAck Channel;
+		uint16_t ChunkIndex;
+		uint16_t ChunkCount;
+	};
+
+	struct BodyDelta {
+		uint32_t Index;
+		TriangleData State;
+	};
+
+	// Set in a BodyEvent index for a despawn, a spawned body's state follows in the same packet
+	constexpr uint32_t BODY_EVENT_DESPAWN = 0x8000'0000u;
+
+	struct BodyEvent {
+		uint32_t Index;
+	};
+
+	// Echoes the snapshot's send time for round trip measurement, zero when sent only to ack the channel
+	struct AckMessage {
+		static constexpr MessageType Type = MessageType::Ack;
+		uint32_t Sequence;
+		int64_t EchoTimeNs;
+		ChannelAck Channel;
+	};
+
+	// An impulse applied at a world point, ViewSequence is the snapshot the client was looking at
+	// and TicksSinceView how far its local simulation had run past it
+	struct InputMessage {
+		static constexpr MessageType Type = MessageType::Input;
+		uint32_t Sequence;
+		uint32_t ViewSequence;
+		uint16_t TicksSinceView;
+		float PointX;
+		float PointY;
+		float ImpulseX;
+		float ImpulseY;
+	};
+
+	struct PingMessage {
+		static constexpr MessageType Type = MessageType::Ping;
+		uint32_t Id;
+		uint32_t Reply;
+		int64_t SendTimeNs;
+	};
+
+	struct GravityMessage {
+		static constexpr MessageType Type = MessageType::Gravity;
+		float Modifier;
+	};
+
+	// Sent by a client until it holds a keyframe, and again whenever a lost delta leaves it out of sync.
+	// Compression holds the client's capability bits, DictionaryId the dictionary it has loaded.
+	struct JoinMessage {
+		static constexpr MessageType Type = MessageType::Join;
+		int64_t SendTimeNs;
+		uint8_t Compression;
+		uint32_t DictionaryId;
+	};
+
+	// One chunk of a full-state keyframe, followed by a live bit and a moving-body bit per body (LSB first),
+	// then a QuantizedPose for every live body and a QuantizedVelocity after the pose of each moving body
+	struct KeyframeMessage {
+		static constexpr MessageType Type = MessageType::Keyframe;
+		uint32_t Sequence;
+		int64_t SendTimeNs;
+		uint32_t BodyCount;
+		uint16_t ChunkIndex;
+		uint16_t ChunkCount;
+		uint32_t FirstBody;
+		uint16_t ChunkBodies;
+
+		// World parameters
+		float Gravity;
+
+		// Hash of the compiled scene the server simulates, clients refuse a keyframe of another scene
+		uint64_t SceneHash;
+
+		// Scene bodies the server starts and resets with live, the baseline of a delta with the reset flag
+		uint32_t InitialBodies;
+	};
+
+	struct QuantizedPose {
+		int16_t X;
+		int16_t Y;
+		int16_t Angle;
+	};
+
+	struct QuantizedVelocity {
+		int16_t X;
+		int16_t Y;
+		int16_t Angular;
+	};
+
+	// Followed by a whole packet delivered in Sequence order
+	struct ReliableMessage {
+		static constexpr MessageType Type = MessageType::Reliable;
+		uint16_t Sequence;
+		ChannelAck Channel;
+	};
+
+	// Field descriptors, members are serialized in the listed order
+
+	template <typename T>
+	struct MessageSchema;
+
+	template <> struct MessageSchema<PacketHeader> {
+		static constexpr auto Fields = std::tuple { &PacketHeader::Magic, &PacketHeader::Version, &PacketHeader::Type, &PacketHeader::Flags, &PacketHeader::Size };
+	};
+
+	template <> struct MessageSchema<TriangleData> {
+		static constexpr auto Fields = std::tuple { &TriangleData::SpatialData, &TriangleData::PhysicsData };
+	};
+
+	template <> struct MessageSchema<ChannelAck> {
+		static constexpr auto Fields = std::tuple { &ChannelAck::Next, &ChannelAck::Bits };
+	};
+
+	template <> struct MessageSchema<SnapshotMessage> {
+		static constexpr auto Fields = std::tuple { &SnapshotMessage::Sequence, &SnapshotMessage::SendTimeNs, &SnapshotMessage::BodyCount, &SnapshotMessage::EventCount, &SnapshotMessage::Channel,
+			&SnapshotMessage::ChunkIndex, &SnapshotMessage::ChunkCount };
+	};
+
+	template <> struct MessageSchema<DeltaMessage> {
+		static constexpr auto Fields = std::tuple { &DeltaMessage::Sequence, &DeltaMessage::BaselineSequence, &DeltaMessage::SendTimeNs, &DeltaMessage::BodyCount, &DeltaMessage::EventCount, &DeltaMessage::ChangedCount, &DeltaMessage::Channel,
+			&DeltaMessage::ChunkIndex, &DeltaMessage::ChunkCount };
+	};
+
+	template <> struct MessageSchema<BodyDelta> {
+		static constexpr auto Fields = std::tuple { &BodyDelta::Index, &BodyDelta::State };
+	};
+
+	template <> struct MessageSchema<BodyEvent> {
+		static constexpr auto Fields = std::tuple { &BodyEvent::Index };
+	};
+
+	template <> struct MessageSchema<AckMessage> {
+		static constexpr auto Fields = std::tuple { &AckMessage::Sequence, &AckMessage::EchoTimeNs, &AckMessage::Channel };
+	};
+
+	template <> struct MessageSchema<InputMessage> {
+		static constexpr auto Fields = std::tuple { &InputMessage::Sequence, &InputMessage::ViewSequence, &InputMessage::TicksSinceView, &InputMessage::PointX, &InputMessage::PointY, &InputMessage::ImpulseX, &InputMessage::ImpulseY };
+	};
+
+	template <> struct MessageSchema<PingMessage> {
+		static constexpr auto Fields = std::tuple { &PingMessage::Id, &PingMessage::Reply, &PingMessage::SendTimeNs };
+	};
+
+	template <> struct MessageSchema<GravityMessage> {
+		static constexpr auto Fields = std::tuple { &GravityMessage::Modifier };
+	};
+
+	template <> struct MessageSchema<JoinMessage> {
+		static constexpr auto Fields = std::tuple { &JoinMessage::SendTimeNs, &JoinMessage::Compression, &JoinMessage::DictionaryId };
+	};
+
+	template <> struct MessageSchema<KeyframeMessage> {
+		static constexpr auto Fields = std::tuple { &KeyframeMessage::Sequence, &KeyframeMessage::SendTimeNs, &KeyframeMessage::BodyCount,
+			&KeyframeMessage::ChunkIndex, &KeyframeMessage::ChunkCount, &KeyframeMessage::FirstBody, &KeyframeMessage::ChunkBodies, &KeyframeMessage::Gravity,
+			&KeyframeMessage::SceneHash, &KeyframeMessage::InitialBodies };
+	};
+
+	template <> struct MessageSchema<QuantizedPose> {
+		static constexpr auto Fields = std::tuple { &QuantizedPose::X, &QuantizedPose::Y, &QuantizedPose::Angle };
+	};
+
+	template <> struct MessageSchema<QuantizedVelocity> {
+		static constexpr auto Fields = std::tuple { &QuantizedVelocity::X, &QuantizedVelocity::Y, &QuantizedVelocity::Angular };
+	};
+
+	template <> struct MessageSchema<ReliableMessage> {
+		static constexpr auto Fields = std::tuple { &ReliableMessage::Sequence, &ReliableMessage::Channel };
+	};
+
+	template <typename T>
+	concept WireScalar = std::is_arithmetic_v<T> || std::is_enum_v<T>;
+
+	template <typename T>
+	concept WireMessage = requires { MessageSchema<T>::Fields; };
+
+	template <typename T>
+	struct MemberPointerTraits;
+
+	template <typename Class, typename Member>
+	struct MemberPointerTraits<Member Class::*> {
+		using Type = Member;
+	};
+
+	template <size_t Size>
+	using WireBits = std::conditional_t<Size == 1, uint8_t,
+		std::conditional_t<Size == 2, uint16_t,
+		std::conditional_t<Size == 4, uint32_t, uint64_t>>>;
+
+	template <typename T>
+	constexpr size_t WireSize() {
+		if constexpr (WireScalar<T>) {
+			return sizeof(T);
+		}
+		else if constexpr (std::is_array_v<T>) {
+			return std::extent_v<T> * WireSize<std::remove_extent_t<T>>();
+		}
+		else {
+			return std::apply([](const auto... members) {
+				return (size_t { 0 } + ... + WireSize<typename MemberPointerTraits<std::remove_cv_t<decltype(members)>>::Type>());
+			}, MessageSchema<T>::Fields);
+		}
+	}
+
+	constexpr size_t PACKET_HEADER_SIZE = WireSize<PacketHeader>();
+
+	// Largest UDP payload over IPv4
+	constexpr size_t MAX_DATAGRAM_SIZE = 65'507;
+
+	// Every packet fits one datagram below a 1500 byte MTU whatever the body count, state that does not is chunked
+	constexpr size_t MAX_PACKET_SIZE = 1400;
+	constexpr size_t MAX_PACKET_PAYLOAD = MAX_PACKET_SIZE - PACKET_HEADER_SIZE;
+
+	static_assert(MAX_PACKET_SIZE <= MAX_DATAGRAM_SIZE);
+
+	// Payload bytes per snapshot or delta chunk, the room the larger of the two messages leaves in a packet
+	constexpr size_t SNAPSHOT_CHUNK_BYTES = MAX_PACKET_PAYLOAD - std::max(WireSize<SnapshotMessage>(), WireSize<DeltaMessage>());
+
+	// A whole snapshot or delta payload, reassembled from its chunks before it is decompressed and decoded
+	constexpr size_t MAX_SNAPSHOT_PAYLOAD = COUNT_TRIANGLES * (WireSize<BodyEvent>() + std::max(WireSize<TriangleData>(), WireSize<BodyDelta>()));
+
+	static_assert((MAX_SNAPSHOT_PAYLOAD + SNAPSHOT_CHUNK_BYTES - 1) / SNAPSHOT_CHUNK_BYTES <= UINT16_MAX,
+		"NETPHYSICS_BODY_COUNT is too large for the 16-bit snapshot chunk index");
+
+	// Largest packet carried inside a reliable message
+	constexpr size_t MAX_RELIABLE_PAYLOAD = 1024;
+
+	static_assert(WireSize<ReliableMessage>() + MAX_RELIABLE_PAYLOAD <= MAX_PACKET_PAYLOAD);
+
+	// Chunks of one snapshot or delta payload collected until all of them arrived, a chunk of a newer one restarts it
+	struct SnapshotAssembly {
+		uint32_t Sequence = 0;
+		MessageType Type = MessageType::Snapshot;
+		uint8_t Flags = 0;
+		std::vector<std::byte> Payload;
+		std::vector<bool> Received;
+		size_t Remaining = 0;
+	};
+
+	// Serialization, both sides flag Overflow instead of reading or writing past the buffer
+
+	struct ByteWriter {
+		std::span<std::byte> Buffer;
+		size_t Offset = 0;
+		bool Overflow = false;
+	};
+
+	struct ByteReader {
+		std::span<const std::byte> Buffer;
+		size_t Offset = 0;
+		bool Overflow = false;
+	};
+
+	template <typename T>
+	void WriteField(ByteWriter& writer, const T& value) {
+		if constexpr (WireScalar<T>) {
+			if (writer.Offset + sizeof(T) > writer.Buffer.size()) {
+				writer.Overflow = true;
+				return;
+			}
+
+			const auto bits = std::bit_cast<WireBits<sizeof(T)>>(value);
+			for (size_t i = 0; i < sizeof(T); i++) {
+				writer.Buffer[writer.Offset + i] = static_cast<std::byte>(bits >> (8 * i));
+			}
+
+			writer.Offset += sizeof(T);
+		}
+		else if constexpr (std::is_array_v<T>) {
+			for (const auto& element : value) WriteField(writer, element);
+		}
+		else {
+			std::apply([&](const auto... members) { (WriteField(writer, value.*members), ...); }, MessageSchema<T>::Fields);
+		}
+	}
+
+	template <typename T>
+	void ReadField(ByteReader& reader, T& value) {
+		if constexpr (WireScalar<T>) {
+			if (reader.Offset + sizeof(T) > reader.Buffer.size()) {
+				reader.Overflow = true;
+				return;
+			}
+
+			WireBits<sizeof(T)> bits = 0;
+			for (size_t i = 0; i < sizeof(T); i++) {
+				bits |= static_cast<WireBits<sizeof(T)>>(std::to_integer<uint8_t>(reader.Buffer[reader.Offset + i])) << (8 * i);
+			}
+
+			value = std::bit_cast<T>(bits);
+			reader.Offset += sizeof(T);
+		}
+		else if constexpr (std::is_array_v<T>) {
+			for (auto& element : value) ReadField(reader, element);
+		}
+		else {
+			std::apply([&](const auto... members) { (ReadField(reader, value.*members), ...); }, MessageSchema<T>::Fields);
+		}
+	}
+
+	size_t BeginPacket(ByteWriter& writer, MessageType type);
+
+	void EndPacket(ByteWriter& writer, size_t start);
+
+	template <WireMessage T>
+	size_t EncodePacket(const T& message, const std::span<std::byte> out) {
+		ByteWriter writer { out };
+		const size_t start = BeginPacket(writer, T::Type);
+		WriteField(writer, message);
+		EndPacket(writer, start);
+		return writer.Overflow ? 0 : writer.Offset;
+	}
+
+	// Header and message of a packet whose trailing bytes are encoded separately and sent right behind it
+	template <WireMessage T>
+	size_t EncodePacketPrefix(const T& message, const size_t trailingBytes, const std::span<std::byte> out, const uint8_t flags = 0) {
+		ByteWriter writer { out };
+		WriteField(writer, PacketHeader { PROTOCOL_MAGIC, PROTOCOL_VERSION, T::Type, flags,
+			static_cast<uint32_t>(WireSize<T>() + trailingBytes) });
+		WriteField(writer, message);
+		return writer.Overflow ? 0 : writer.Offset;
+	}
+
+	// A spawn or despawn, by the state in live, for every body set in events
+	size_t EncodeBodyEvents(const BodyMask& events, const BodyMask& live, std::span<std::byte> out);
+
+	size_t EncodeSnapshotBodies(std::span<const TriangleData> bodies, std::span<std::byte> out);
+
+	size_t EncodeDeltaBodies(std::span<const TriangleData> bodies, const BodyMask& changed, std::span<std::byte> out);
+
+	// Whole packets without body events, message.EventCount must be 0
+	size_t EncodeSnapshotPacket(const SnapshotMessage& message, std::span<const TriangleData> bodies, std::span<std::byte> out);
+
+	size_t EncodeDeltaPacket(DeltaMessage message, std::span<const TriangleData> bodies, const BodyMask& changed, std::span<std::byte> out);
+
+	bool ReadPacketHeader(std::span<const std::byte> data, PacketHeader& header);
+
+	// Chunks needed for a snapshot or delta payload of size bytes, an empty delta still takes one
+	uint16_t SnapshotChunkCount(size_t size);
+
+	/// <summary>Adds one snapshot or delta chunk to the assembly.</summary>
+	/// <param name="assembly">Chunks collected so far</param>
+	/// <param name="header">Header of the chunk's packet, its type and flags must match the other chunks</param>
+	/// <param name="sequence">Sequence of the snapshot or delta</param>
+	/// <param name="chunkIndex">Index of the chunk</param>
+	/// <param name="chunkCount">Chunks of the whole payload</param>
+	/// <param name="reader">Positioned at the chunk's payload bytes</param>
+	/// <returns>False for a malformed chunk or one of an older sequence than the assembly</returns>
+	bool AddSnapshotChunk(SnapshotAssembly& assembly, const PacketHeader& header, uint32_t sequence, uint16_t chunkIndex,
+		uint16_t chunkCount, const ByteReader& reader);
+
+	bool SnapshotComplete(const SnapshotAssembly& assembly);
+
+	// Reader positioned at the payload of a whole packet, including its header
+	ByteReader PacketPayload(std::span<const std::byte> packet);
+
+	template <WireMessage T>
+	bool DecodeMessage(ByteReader& reader, T& message) {
+		ReadField(reader, message);
+		return !reader.Overflow;
+	}
+
+	// Applies count body events to live, false for a malformed event or one past the last slot
+	bool DecodeBodyEvents(ByteReader& reader, uint32_t count, BodyMask& live);
+
+	bool DecodeSnapshotBodies(ByteReader& reader, const SnapshotMessage& message, std::span<TriangleData> bodies);
+
+	bool DecodeDeltaBodies(ByteReader& reader, const DeltaMessage& message, std::span<TriangleData> bodies);
+}
\ No newline at end of file
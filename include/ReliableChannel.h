@@ -0,0 +1,52 @@
+#pragma once
+
+namespace NetPhysics {
+
+	// Messages in flight per direction, a wider window needs more ack bits
+	constexpr uint16_t RELIABLE_WINDOW = 32;
+
+	constexpr int64_t RELIABLE_RESEND_NS = 100'000'000;
+
+	static_assert(RELIABLE_WINDOW <= 33, "ChannelAck covers Next plus 32 following sequences");
+
+	struct ReliableSlot {
+		std::vector<std::byte> Packet;
+		int64_t LastSendNs = 0;
+		bool Pending = false;
+	};
+
+	struct ReliableReceiveSlot {
+		std::vector<std::byte> Packet;
+		bool Filled = false;
+	};
+
+	// Reliable ordered messages multiplexed next to the unreliable snapshots. Outgoing messages are
+	// resent individually until acked, incoming ones are buffered until every earlier sequence arrived.
+	struct ReliableChannel {
+		uint16_t NextSequence = 0;
+		uint16_t OldestUnacked = 0;
+		ReliableSlot Sent[RELIABLE_WINDOW];
+
+		// Waiting for room in the window
+		std::deque<std::vector<std::byte>> Queued;
+
+		uint16_t NextExpected = 0;
+		ReliableReceiveSlot Received[RELIABLE_WINDOW];
+
+		uint64_t Resends = 0;
+	};
+
+	bool ChannelIdle(const ReliableChannel& channel);
+
+	void ChannelQueue(ReliableChannel& channel, std::span<const std::byte> packet);
+
+	ChannelAck ChannelMakeAck(const ReliableChannel& channel);
+
+	void ChannelProcessAck(ReliableChannel& channel, const ChannelAck& ack);
+
+	// Calls send with a whole Reliable packet for every message due for its first send or a resend
+	void ChannelFlush(ReliableChannel& channel, int64_t nowNs, const std::function<void(std::span<const std::byte>)>& send);
+
+	// Calls deliver with the wrapped packets that became deliverable in order, returns false for a malformed message
+	bool ChannelReceive(ReliableChannel& channel, ByteReader& reader, const std::function<void(std::span<const std::byte>)>& deliver);
+}
\ No newline at end of file
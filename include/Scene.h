@@ -0,0 +1,151 @@
+#pragma once
+
+namespace NetPhysics {
+
+	// Compiled scene files are a SceneHeader followed by the shape, material, static body and body tables,
+	// little-endian and 4-byte aligned so a mapped file is used in place
+	constexpr uint32_t SCENE_MAGIC = 0x4E435350; // "PSCN"
+	constexpr uint32_t SCENE_VERSION = 1;
+
+	// Same as b2_maxPolygonVertices
+	constexpr int SCENE_MAX_VERTICES = 8;
+
+	struct SceneHeader {
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t ShapeCount;
+		uint32_t MaterialCount;
+		uint32_t StaticCount;
+		uint32_t BodyCount;
+	};
+
+	// Convex polygon, boxes are stored as their four corners
+	struct SceneShape {
+		uint32_t VertexCount;
+		float Vertices[SCENE_MAX_VERTICES][2];
+	};
+
+	struct SceneMaterial {
+		float Density;
+		float Friction;
+		float Restitution;
+	};
+
+	struct SceneStatic {
+		uint32_t Shape;
+		uint32_t Material;
+		float X;
+		float Y;
+		float Angle;
+	};
+
+	// Dynamic bodies all use the triangle shape, the only mesh the renderer instances
+	struct SceneBody {
+		uint32_t Material;
+		TriangleData State;
+	};
+
+	static_assert(std::endian::native == std::endian::little);
+	static_assert(sizeof(SceneHeader) == 24 && sizeof(SceneShape) == 68 && sizeof(SceneMaterial) == 12
+		&& sizeof(SceneStatic) == 20 && sizeof(SceneBody) == 28);
+
+	constexpr SceneMaterial DEFAULT_STATIC_MATERIAL { 0.0f, 0.2f, 0.0f };
+	constexpr SceneMaterial DEFAULT_BODY_MATERIAL { 10.0f, 0.3f, 1.0f };
+
+	// A scene as parsed from its text form, before compiling
+	struct SceneDescription {
+		std::vector<SceneShape> Shapes;
+		std::vector<SceneMaterial> Materials;
+		std::vector<SceneStatic> Statics;
+		std::vector<SceneBody> Bodies;
+	};
+
+	// A compiled scene, the tables point into a mapped file or into Compiled. Released with UnloadScene.
+	struct Scene {
+		// FNV-1a of the compiled bytes, server and clients must agree on it
+		uint64_t Hash = 0;
+		size_t Bytes = 0;
+
+		std::span<const SceneShape> Shapes;
+		std::span<const SceneMaterial> Materials;
+		std::span<const SceneStatic> Statics;
+		std::span<const SceneBody> Bodies;
+
+		std::vector<std::byte> Compiled;
+		HANDLE Mapping = nullptr;
+		const void* View = nullptr;
+	};
+
+	// Scene the worlds are built from, loaded before any world is created
+	inline Scene ActiveScene;
+
+	// Functions
+
+	uint64_t HashSceneBytes(std::span<const std::byte> bytes);
+
+	/// <summary>Parses the text form of a scene, one directive per line:
+	/// shape NAME box HALF_WIDTH HALF_HEIGHT, shape NAME polygon X Y X Y X Y ...,
+	/// material NAME DENSITY FRICTION RESTITUTION, static SHAPE MATERIAL X Y ANGLE,
+	/// body MATERIAL X Y ANGLE VX VY ANGULAR_VELOCITY and grid MATERIAL COUNT COLUMNS X Y SPACING VX VY.
+	/// Everything after a # is a comment. Errors are printed with their line number.</summary>
+	/// <param name="filename">Scene text file</param>
+	/// <param name="scene">Receives the parsed scene</param>
+	/// <returns>Whether the whole file parsed</returns>
+	bool ParseSceneText(const std::string& filename, SceneDescription& scene);
+
+	/// <summary>Lays a scene out in its binary form.</summary>
+	/// <param name="scene">The scene to compile</param>
+	/// <returns>The bytes of a compiled scene file</returns>
+	std::vector<std::byte> CompileScene(const SceneDescription& scene);
+
+	/// <summary>Validates compiled scene bytes and points the scene's tables into them.</summary>
+	/// <param name="bytes">Compiled scene, must outlive the scene</param>
+	/// <param name="scene">Receives the tables and hash</param>
+	/// <returns>False if the bytes are not a valid scene for this build</returns>
+	bool ViewScene(std::span<const std::byte> bytes, Scene& scene);
+
+	/// <summary>Loads a scene, memory-mapping compiled .bin files and compiling text files in memory.</summary>
+	/// <param name="filename">Scene file</param>
+	/// <param name="scene">Unloaded scene to fill</param>
+	/// <returns>Whether the scene was loaded</returns>
+	bool LoadScene(const std::string& filename, Scene& scene);
+
+	/// <summary>Returns the starting position of a body on the spawn grid, centered on the origin.</summary>
+	/// <param name="index">Index of the body</param>
+	b2Vec2 GridCell(int index);
+
+	/// <summary>Compiles the built-in scene, four walls around a grid of COUNT_TRIANGLES bodies.</summary>
+	/// <param name="scene">Unloaded scene to fill</param>
+	void BuildDefaultScene(Scene& scene);
+
+	void UnloadScene(Scene& scene);
+
+	/// <summary>Compiles a scene text file into a binary one.</summary>
+	/// <param name="input">Scene text file</param>
+	/// <param name="output">Compiled scene file to write</param>
+	/// <returns>Whether the scene was written</returns>
+	bool CompileSceneFile(const std::string& input, const std::string& output);
+
+	/// <summary>Writes the state a world of the scene starts in with its first liveCount bodies live,
+	/// the other slots parked in the pool.</summary>
+	/// <param name="scene">The scene the bodies start from</param>
+	/// <param name="liveCount">Bodies live from the start, at most the bodies of the scene are</param>
+	/// <param name="bodies">Receives COUNT_TRIANGLES states</param>
+	/// <param name="live">Receives the live bit of every slot</param>
+	/// <returns>The number of live bodies</returns>
+	int SceneInitialState(const Scene& scene, int liveCount, std::span<TriangleData> bodies, BodyMask& live);
+
+	/// <summary>Creates the static bodies of the active scene.</summary>
+	/// <param name="world">The world in which the bodies are instantiated</param>
+	/// <param name="statics">Receives the created bodies</param>
+	void CreateSceneStatics(b2World& world, std::vector<b2Body*>& statics);
+
+	/// <summary>Returns the polygon shape of every triangle body, built on first use.</summary>
+	const b2PolygonShape& TriangleShape();
+
+	/// <summary>Creates a single triangle body with the shared triangle fixture.</summary>
+	/// <param name="world">The world in which the triangle is instantiated</param>
+	/// <param name="bodyDef">Definition of the body</param>
+	/// <param name="material">Density, friction and restitution of the fixture</param>
+	b2Body* CreateTriangleBody(b2World& world, const b2BodyDef& bodyDef, const SceneMaterial& material);
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+namespace NetPhysics {
+
+	// Linked program binaries are cached per program in this directory, relative to the working directory
+	constexpr const char* SHADER_CACHE_DIRECTORY = "shader_cache";
+
+	constexpr uint32_t SHADER_CACHE_MAGIC = 0x4E435342;
+	constexpr uint32_t SHADER_CACHE_VERSION = 1;
+
+	// Precedes the driver's program binary in a cache file. A binary is only handed back to the driver
+	// when both hashes still match, anything else is recompiled from source.
+	struct ShaderCacheHeader {
+		uint32_t Magic;
+		uint32_t Version;
+
+		// Names and sources of both shader stages
+		uint64_t SourceHash;
+
+		// GL vendor, renderer and version strings, a driver update invalidates every binary
+		uint64_t DriverHash;
+
+		uint32_t Format;
+		uint32_t Length;
+	};
+
+	static_assert(sizeof(ShaderCacheHeader) == 32);
+
+	// Shader cache globals
+
+	// Cleared by -no-shader-cache, programs are then always compiled and nothing is written
+	inline bool ShaderCacheEnabled = true;
+
+	// How the last program was built, shown in the window
+	inline bool ShaderProgramCached = false;
+
+	// Functions
+
+	/// <summary>Returns the FNV-1a hash of text, continuing from a previous hash.</summary>
+	/// <param name="text">The text to hash</param>
+	/// <param name="hash">Hash of the preceding text</param>
+	uint64_t HashShaderText(std::string_view text, uint64_t hash = 0xCBF29CE484222325);
+
+	/// <summary>Compiles one shader stage, printing the info log on failure.</summary>
+	/// <param name="type">GL_VERTEX_SHADER or GL_FRAGMENT_SHADER</param>
+	/// <param name="source">GLSL source</param>
+	/// <param name="filename">Shown with compile errors</param>
+	/// <returns>The shader, or 0 when it failed to compile</returns>
+	GLuint CompileShaderStage(GLenum type, const std::string& source, const std::string& filename);
+
+	/// <summary>Links a program, printing the info log on failure.</summary>
+	/// <param name="program">Program with its stages attached</param>
+	/// <param name="name">Shown with link errors</param>
+	bool LinkShaderProgram(GLuint program, const std::string& name);
+
+	/// <summary>Creates a program from its cached binary. Files that are truncated, were written for other
+	/// sources or another driver, or that the driver rejects are deleted.</summary>
+	/// <param name="cacheFile">Path of the cache file</param>
+	/// <param name="sourceHash">Hash of the current sources</param>
+	/// <param name="driverHash">Hash of the current driver</param>
+	/// <returns>The linked program, or 0 when there was no usable binary</returns>
+	GLuint LoadCachedProgram(const std::filesystem::path& cacheFile, uint64_t sourceHash, uint64_t driverHash);
+
+	/// <summary>Writes the binary of a linked program to the cache, through a temporary file so a
+	/// crash never leaves a partial binary behind.</summary>
+	/// <param name="program">Program linked with the retrievable hint</param>
+	/// <param name="cacheFile">Path of the cache file</param>
+	/// <param name="sourceHash">Hash of the sources</param>
+	/// <param name="driverHash">Hash of the driver</param>
+	void StoreProgramBinary(GLuint program, const std::filesystem::path& cacheFile, uint64_t sourceHash, uint64_t driverHash);
+
+	/// <summary>Returns the linked program for the given sources, from the cache where the driver supports
+	/// program binaries and compiled otherwise.</summary>
+	/// <param name="name">Names the cache file and error messages</param>
+	/// <param name="vertexSource">Vertex shader source</param>
+	/// <param name="fragmentSource">Fragment shader source</param>
+	/// <returns>The program, or 0 when it failed to compile or link</returns>
+	GLuint BuildShaderProgram(const std::string& name, const std::string& vertexSource, const std::string& fragmentSource);
+}
\ No newline at end of file
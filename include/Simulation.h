@@ -0,0 +1,68 @@
+#pragma once
+
+namespace NetPhysics {
+
+	// Simulation globals
+
+	constexpr int SIMULATION_TICK_RATE = 60;
+
+	// Ticks the simulation may fall behind before it skips ahead instead of catching up
+	constexpr int MAX_CATCH_UP_TICKS = 4;
+
+	struct RenderState {
+		double Time = 0.0;
+		InstanceArrays Bodies;
+	};
+
+	// The render thread takes the previous and current state under RenderStateMutex and interpolates them
+	// outside of it, the simulation thread writes the back state and picks a new one that neither of the
+	// two pairs uses. Previous, current and the two read by the render thread leave one of five free.
+	inline RenderState RenderStates[5];
+	inline RenderState* PreviousRenderState = &RenderStates[0];
+	inline RenderState* CurrentRenderState = &RenderStates[1];
+	inline RenderState* BackRenderState = &RenderStates[2];
+	inline const RenderState* ReadRenderStates[2] = { &RenderStates[0], &RenderStates[1] };
+	inline std::mutex RenderStateMutex;
+
+	// Requests from the render thread, applied at the start of the next tick
+	inline std::atomic<float> GravityModifier;
+	inline std::atomic<bool> ResetRequested;
+
+	// Clients started with -thin build no Box2D world, the state received into TriData is all they hold
+	inline bool ThinClient = false;
+
+	// Servers started with -headless open no window, so no render states are published
+	inline bool Headless = false;
+
+	inline std::atomic<double> LastTickMs;
+
+	// Duration of the last ResetSimulation
+	inline std::atomic<double> LastResetMs;
+
+	// Ticks run so far, which is also the number of the tick the bodies are at
+	inline std::atomic<uint32_t> SimulationTicks;
+
+	// Functions
+
+	/// <summary>Returns the time in seconds used to timestamp and interpolate render states.</summary>
+	double SimulationTime();
+
+	/// <summary>Captures body poses into the back render state and makes it the current one.</summary>
+	/// <param name="time">Timestamp of the captured state</param>
+	void PublishRenderState(double time);
+
+	/// <summary>Runs one fixed simulation tick: applies requests, steps the shards and publishes the result.</summary>
+	/// <param name="isServer">Whether snapshot data is collected for clients</param>
+	void SimulationTick(bool isServer);
+
+	/// <summary>Runs simulation ticks at SIMULATION_TICK_RATE until the flag is set.</summary>
+	/// <param name="running">Flag that stops the loop when set</param>
+	/// <param name="isServer">Whether snapshot data is collected for clients</param>
+	void SimulationLoop(const RunningFlag& running, bool isServer);
+
+	/// <summary>Writes instance data interpolated between the two latest render states.</summary>
+	/// <param name="renderTime">Time to display, one tick behind the present so both states exist</param>
+	/// <param name="layout">Layout of the instance data</param>
+	/// <param name="instances">Destination for COUNT_TRIANGLES instances</param>
+	void WriteInterpolatedInstances(double renderTime, InstanceLayout layout, void* instances);
+}
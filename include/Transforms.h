@@ -0,0 +1,33 @@
+#pragma once
+
+namespace NetPhysics {
+
+	// Per-body instance data in structure-of-arrays form, filled from the bodies before building transforms
+
+	struct InstanceArrays {
+		float PositionX[COUNT_TRIANGLES];
+		float PositionY[COUNT_TRIANGLES];
+		float Angle[COUNT_TRIANGLES];
+	};
+
+	inline InstanceArrays TriangleInstances;
+
+	// Functions
+
+	/// <summary>Builds model matrices equal to translate(x, y) * rotateZ(angle) for a batch of bodies.
+	/// Uses SSE2 four bodies at a time where available, with a scalar path for the remainder.</summary>
+	/// <param name="x">Position x of each body</param>
+	/// <param name="y">Position y of each body</param>
+	/// <param name="angle">Rotation of each body in radians</param>
+	/// <param name="out">Receives one matrix per body</param>
+	/// <param name="count">Number of bodies</param>
+	void BuildInstanceTransforms(const float* x, const float* y, const float* angle, mat4x4* out, int count);
+
+	/// <summary>Scalar reference version of BuildInstanceTransforms.</summary>
+	/// <param name="x">Position x of each body</param>
+	/// <param name="y">Position y of each body</param>
+	/// <param name="angle">Rotation of each body in radians</param>
+	/// <param name="out">Receives one matrix per body</param>
+	/// <param name="count">Number of bodies</param>
+	void BuildInstanceTransformsScalar(const float* x, const float* y, const float* angle, mat4x4* out, int count);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+namespace NetPhysics {
+
+	struct WorldShard {
+		std::unique_ptr<b2World> World;
+		std::vector<b2Body*> Statics;
+
+		// Dynamic stand-ins for bodies owned by a neighbouring shard, indexed like Triangles. Created once
+		// and kept, the owner's slot is always empty.
+		b2Body* Ghosts[COUNT_TRIANGLES] {};
+	};
+
+	// Shard globals
+
+	constexpr float ARENA_MIN_X = -ARENA_HALF_EXTENT;
+	constexpr float ARENA_MAX_X = ARENA_HALF_EXTENT;
+
+	// Distance from a shard boundary within which a body is mirrored into the neighbouring shard
+	constexpr float SHARD_GHOST_MARGIN = 1.0f;
+
+	// Ghosts collide with the bodies and statics of their shard but not with each other
+	constexpr uint16_t SHARD_GHOST_CATEGORY = 0x0002;
+
+	inline std::vector<WorldShard> Shards;
+	inline int TriangleShards[COUNT_TRIANGLES];
+
+	// Functions
+
+	/// <summary>Splits the arena into vertical strips, each simulated by its own world.</summary>
+	/// <param name="count">Number of shards</param>
+	/// <param name="gravity">Initial gravity of every shard</param>
+	void CreateWorldShards(int count, const b2Vec2& gravity);
+
+	/// <summary>Creates the active scene's bodies into the world shards, the remaining slots are created pooled.</summary>
+	void CreatePhysicsTriangles();
+
+	/// <summary>Destroys all shard worlds and the bodies in them.</summary>
+	void DestroyWorldShards();
+
+	/// <summary>Returns the material of a body's fixture, which its ghosts in other shards are created with.</summary>
+	/// <param name="body">Body with a single fixture</param>
+	SceneMaterial BodyMaterial(const b2Body* body);
+
+	/// <summary>Returns the index of the shard that owns the given x coordinate.</summary>
+	/// <param name="x">World space x coordinate</param>
+	int ShardForPosition(float x);
+
+	/// <summary>Sets the gravity of every shard.</summary>
+	/// <param name="gravity">The new gravity</param>
+	void SetShardGravity(const b2Vec2& gravity);
+
+	/// <summary>Mirrors bodies close to a shard boundary into the neighbouring shard as ghosts. A ghost is a dynamic body
+	/// with the owner's mass and current state, stepped with its shard and overwritten again before the next step. Both
+	/// worlds thus solve a seam contact from the same states and masses and each keeps the impulse on the body it owns,
+	/// which conserves momentum up to the other contacts each world sees. Contacts reaching more than SHARD_GHOST_MARGIN
+	/// across a seam are not seen.</summary>
+	void SyncShardGhosts();
+
+	/// <summary>Hands bodies that have left their shard's strip to the shard that now owns them. The body's ghost there
+	/// takes over with the owner's state, keeping its contacts, and the old body stays behind as the ghost.</summary>
+	void MigrateShardBodies();
+
+	/// <summary>Steps every shard in parallel on the job workers, then migrates bodies across boundaries.</summary>
+	/// <param name="timeStep">Simulation time step</param>
+	/// <param name="velocityIterations">Velocity solver iterations</param>
+	/// <param name="positionIterations">Position solver iterations</param>
+	void StepWorldShards(float timeStep, int velocityIterations, int positionIterations);
+}
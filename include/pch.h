@@ -5,6 +5,7 @@
 #define WIN32_LEAN_AND_MEAN
 
 #include <box2d/box2d.h>
+#include <zstd.h>
 #include <glad/gl.h>
 #include <GLFW/glfw3.h>
 #include <linmath.h>
@@ -12,9 +13,27 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <string>
+#include <filesystem>
 #include <thread>
+#include <mutex>
+#include <algorithm>
 #include <atomic>
 #include <vector>
+#include <array>
+#include <bit>
+#include <span>
+#include <tuple>
+#include <cstring>
+#include <cfloat>
+#include <cmath>
+#include <random>
+#include <deque>
+#include <unordered_map>
+#include <memory>
+#include <numbers>
+#include <numeric>
+#include <functional>
 #include <future>
 #include <WinSock2.h>
 #include <WS2tcpip.h>
@@ -2,7 +2,7 @@
 
 in vec2 PositionOS;
 in vec3 Color;
-in mat4 ModelMatrix; //Instanced matrix
+in vec3 InstancePose; //Instanced x, y and angle
 
 uniform mat4 ViewMatrix;
 uniform mat4 ProjMatrix;
@@ -11,6 +11,9 @@ out vec3 color;
 
 void main()
 {
-    gl_Position = ProjMatrix * ViewMatrix * ModelMatrix * vec4(PositionOS, 0.0, 1.0);
+    float s = sin(InstancePose.z);
+    float c = cos(InstancePose.z);
+    vec2 positionWS = mat2(c, s, -s, c) * PositionOS + InstancePose.xy;
+    gl_Position = ProjMatrix * ViewMatrix * vec4(positionWS, 0.0, 1.0);
     color = Color;
 }
\ No newline at end of file
@@ -0,0 +1,693 @@
+#include <pch.h>
+#include <NetworkingPhysics.h>
+#include <Protocol.h>
+#include <NetworkShim.h>
+#include <ReliableChannel.h>
+#include <Keyframe.h>
+#include <Compression.h>
+#include <Netcode.h>
+#include <Transforms.h>
+#include <Simulation.h>
+#include <DeadReckoning.h>
+#include <BodyPool.h>
+#include <Scene.h>
+#include <JobSystem.h>
+#include <WorldShards.h>
+#include <Config.h>
+#include <Benchmarks.h>
+
+namespace NetPhysics {
+	std::vector<TriangleData> BenchmarkGrid(const int bodyCount, const float x, const float y, const float spacing) {
+		const int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(bodyCount))));
+		std::vector<TriangleData> grid(bodyCount);
+
+		for (int i = 0; i < bodyCount; i++) {
+			grid[i] = TriangleData { { x + static_cast<float>(i % columns) * spacing, y + static_cast<float>(i / columns) * spacing, 0 }, { 0, 0, 0 } };
+		}
+
+		return grid;
+	}
+
+	b2Body* CreateBenchmarkBody(b2World& world, const TriangleData& state, const float density) {
+		const auto& [SpatialData, PhysicsData] = state;
+
+		b2BodyDef bodyDef;
+		bodyDef.type = b2_dynamicBody;
+		bodyDef.position.Set(SpatialData[0], SpatialData[1]);
+		bodyDef.angle = SpatialData[2];
+		bodyDef.linearVelocity.Set(PhysicsData[0], PhysicsData[1]);
+		bodyDef.angularVelocity = PhysicsData[2];
+
+		b2Body* body = world.CreateBody(&bodyDef);
+		body->CreateFixture(&TriangleShape(), density);
+		return body;
+	}
+
+	void SimulateBenchmarkScene(const int bodyCount, const int ticks, const std::function<void(std::span<const TriangleData>)>& onTick) {
+		b2World world(b2Vec2(0, -9.81f));
+		const float half = std::max(20.0f, std::sqrt(static_cast<float>(bodyCount)) * 0.75f);
+
+		b2PolygonShape horizontal;
+		horizontal.SetAsBox(half, 0.5f);
+
+		b2PolygonShape vertical;
+		vertical.SetAsBox(0.5f, half);
+
+		const std::tuple<float, float, b2PolygonShape*> walls[] {
+			{ 0.0f, -half, &horizontal }, { 0.0f, half, &horizontal }, { -half, 0.0f, &vertical }, { half, 0.0f, &vertical }
+		};
+
+		for (const auto& [x, y, shape] : walls) {
+			b2BodyDef wallDef;
+			wallDef.position.Set(x, y);
+			world.CreateBody(&wallDef)->CreateFixture(shape, 0.0f);
+		}
+
+		const int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(bodyCount))));
+		std::vector<TriangleData> initial = BenchmarkGrid(bodyCount, 1.0f - half, 1.0f - half, (2.0f * half - 2.0f) / static_cast<float>(columns));
+
+		std::minstd_rand random(1);
+		std::uniform_real_distribution<float> velocity(-5.0f, 5.0f);
+		std::vector<b2Body*> bodies(bodyCount);
+
+		for (int i = 0; i < bodyCount; i++) {
+			initial[i].PhysicsData[0] = velocity(random);
+			initial[i].PhysicsData[1] = velocity(random);
+			bodies[i] = CreateBenchmarkBody(world, initial[i], 10.0f);
+		}
+
+		std::vector<TriangleData> current(bodyCount);
+
+		for (int tick = 0; tick < ticks; tick++) {
+			world.Step(1.0f / 60.0f, 8, 3);
+
+			for (int i = 0; i < bodyCount; i++) {
+				const b2Vec2 position = bodies[i]->GetPosition();
+				const b2Vec2 linear = bodies[i]->GetLinearVelocity();
+				current[i] = TriangleData { { position.x, position.y, bodies[i]->GetAngle() }, { linear.x, linear.y, bodies[i]->GetAngularVelocity() } };
+			}
+
+			onTick(current);
+		}
+	}
+
+	namespace {
+		// Full snapshot and delta payloads of the benchmark scene, one of each per tick
+		void RecordBenchmarkStream(const int bodyCount, const int ticks, std::vector<std::vector<std::byte>>& full,
+			std::vector<std::vector<std::byte>>& delta) {
+			std::vector<TriangleData> previous(bodyCount);
+
+			SimulateBenchmarkScene(bodyCount, ticks, [&](const std::span<const TriangleData> current) {
+				full.emplace_back(current.size() * WireSize<TriangleData>());
+				EncodeSnapshotBodies(current, full.back());
+
+				delta.emplace_back(current.size() * WireSize<BodyDelta>());
+				ByteWriter writer { delta.back() };
+
+				for (int i = 0; i < bodyCount; i++) {
+					if (std::memcmp(&previous[i], &current[i], sizeof(TriangleData)) != 0)
+						WriteField(writer, BodyDelta { static_cast<uint32_t>(i), current[i] });
+				}
+
+				delta.back().resize(writer.Offset);
+				std::ranges::copy(current, previous.begin());
+			});
+		}
+	}
+
+	void BenchmarkCompression() {
+		// The dictionary is trained on the first half of each stream and measured on the second
+		constexpr int ticks = 120;
+
+		std::cout << "Compression per tick, dictionary trained on " << ticks / 2 << " ticks\n";
+
+		for (const int bodyCount : { 100, 1'000, 10'000 }) {
+			std::vector<std::vector<std::byte>> full, delta;
+			RecordBenchmarkStream(bodyCount, ticks, full, delta);
+
+			for (const auto& [kind, stream] : { std::pair { "full", &full }, std::pair { "delta", &delta } }) {
+				std::vector<std::byte> samples;
+				std::vector<size_t> sizes;
+
+				for (int tick = 0; tick < ticks / 2; tick++) {
+					samples.insert(samples.end(), (*stream)[tick].begin(), (*stream)[tick].end());
+					sizes.push_back((*stream)[tick].size());
+				}
+
+				const auto dictionary = CreateCompressionDictionary(TrainDictionary(samples, sizes));
+
+				for (const CompressionMode mode : { CompressionMode::Zstd, CompressionMode::ZstdDictionary }) {
+					if (mode == CompressionMode::ZstdDictionary && dictionary == nullptr) continue;
+
+					const CompressionDictionary* modeDictionary = mode == CompressionMode::ZstdDictionary ? dictionary.get() : nullptr;
+					size_t rawBytes = 0, frameBytes = 0;
+					int64_t encodeNs = 0, decodeNs = 0;
+					bool valid = true;
+
+					for (int tick = ticks / 2; tick < ticks; tick++) {
+						const std::vector<std::byte>& payload = (*stream)[tick];
+						std::vector<std::byte> frame(ZSTD_compressBound(payload.size()));
+						std::vector<std::byte> decoded(payload.size());
+
+						const auto encodeStart = std::chrono::steady_clock::now();
+						const size_t frameSize = CompressPayload(payload, frame, modeDictionary);
+						const auto decodeStart = std::chrono::steady_clock::now();
+						const size_t decodedSize = DecompressPayload(std::span(frame).first(frameSize), decoded, modeDictionary);
+						const auto decodeEnd = std::chrono::steady_clock::now();
+
+						encodeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(decodeStart - encodeStart).count();
+						decodeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(decodeEnd - decodeStart).count();
+						rawBytes += payload.size();
+						frameBytes += frameSize;
+						valid &= decodedSize == payload.size() && std::ranges::equal(decoded, payload);
+					}
+
+					constexpr double measured = ticks - ticks / 2;
+					std::cout << "  " << bodyCount << " bodies " << kind << " " << CompressionModeNames[static_cast<size_t>(mode)]
+						<< ": " << static_cast<double>(rawBytes) / measured << " -> " << static_cast<double>(frameBytes) / measured << " bytes"
+						<< ", ratio " << static_cast<double>(rawBytes) / static_cast<double>(std::max<size_t>(1, frameBytes))
+						<< ", encode " << static_cast<double>(encodeNs) / measured / 1e3 << " us"
+						<< ", decode " << static_cast<double>(decodeNs) / measured / 1e3 << " us"
+						<< (valid ? "" : ", round trip MISMATCH") << "\n";
+				}
+			}
+		}
+	}
+
+	void BenchmarkProtocol(const int iterations) {
+		std::vector<TriangleData> bodies(COUNT_TRIANGLES);
+		for (size_t i = 0; i < bodies.size(); i++) {
+			const float f = static_cast<float>(i);
+			bodies[i] = TriangleData { { f, -f, f * 0.01f }, { f * 0.5f, f * 0.25f, -f } };
+		}
+
+		// Encoded as one unchunked packet, the throughput of the serialization alone
+		std::vector<std::byte> packet(PACKET_HEADER_SIZE + WireSize<SnapshotMessage>() + MAX_SNAPSHOT_PAYLOAD);
+		const SnapshotMessage message { 1, 0, static_cast<uint32_t>(bodies.size()), 0, {}, 0, 1 };
+		size_t size = 0;
+
+		const auto encodeStart = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations; i++) {
+			size = EncodeSnapshotPacket(message, bodies, packet);
+		}
+		const double encodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - encodeStart).count();
+
+		std::vector<TriangleData> decoded(bodies.size());
+		bool valid = true;
+
+		const auto decodeStart = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations; i++) {
+			ByteReader reader = PacketPayload(std::span(packet).first(size));
+			SnapshotMessage decodedMessage;
+			valid &= DecodeMessage(reader, decodedMessage) && DecodeSnapshotBodies(reader, decodedMessage, decoded);
+		}
+		const double decodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - decodeStart).count();
+
+		valid &= std::memcmp(bodies.data(), decoded.data(), bodies.size() * sizeof(TriangleData)) == 0;
+
+		const double megabytes = static_cast<double>(size) * iterations / 1e6;
+		std::cout << "Snapshot packet " << size << " bytes, " << bodies.size() << " bodies\n"
+			<< "  encode " << megabytes / encodeSeconds << " MB/s\n"
+			<< "  decode " << megabytes / decodeSeconds << " MB/s\n"
+			<< "  round trip " << (valid ? "ok" : "MISMATCH") << "\n";
+	}
+
+	void BenchmarkJoin(const int bodyCount) {
+		if (WSAInit() != 0) return;
+
+		// A settled scene with every tenth body still moving
+		std::vector<TriangleData> bodies(std::max(1, bodyCount));
+		for (size_t i = 0; i < bodies.size(); i++) {
+			const float f = static_cast<float>(i);
+			const float moving = i % 10 == 0 ? 1.0f : 0.0f;
+			bodies[i] = TriangleData { { std::fmod(f * 0.37f, 38.0f) - 19.0f, std::fmod(f * 0.011f, 38.0f) - 19.0f, std::fmod(f, 6.0f) - 3.0f },
+				{ moving * 2.5f, moving * -4.0f, moving * 0.5f } };
+		}
+
+		AddressInfo* addressInfo;
+
+		if (GetAddressInfo(&addressInfo, L"127.0.0.1", L"56790") != 0) {
+			WSACleanup(); return;
+		}
+
+		const Socket serverSocket = CreateDatagramSocket();
+		const bool bound = serverSocket != INVALID_SOCKET && BindSocketToAddress(serverSocket, addressInfo) != SOCKET_ERROR;
+		FreeAddrInfo(addressInfo);
+
+		const Socket clientSocket = bound ? OpenServerConnection(L"127.0.0.1", L"56790") : INVALID_SOCKET;
+
+		if (clientSocket == INVALID_SOCKET) {
+			std::cerr << "Join benchmark could not open loopback sockets\n";
+			if (serverSocket != INVALID_SOCKET) closesocket(serverSocket);
+			WSACleanup(); return;
+		}
+
+		// The whole keyframe is sent in one burst, the receive buffer has to hold it
+		const int receiveBuffer = 16 << 20;
+		setsockopt(clientSocket, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&receiveBuffer), sizeof(receiveBuffer));
+
+		const DWORD timeoutMs = 1000;
+		setsockopt(serverSocket, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeoutMs), sizeof(timeoutMs));
+
+		std::array<std::byte, MAX_PACKET_SIZE> datagram;
+		const int64_t start = NetworkTimeNs();
+
+		std::array<std::byte, PACKET_HEADER_SIZE + WireSize<JoinMessage>()> join;
+		SendBytes(clientSocket, reinterpret_cast<const char*>(join.data()), EncodePacket(JoinMessage { start, 0, 0 }, join));
+
+		sockaddr_in from {};
+		int fromLength = sizeof(from);
+
+		if (recvfrom(serverSocket, reinterpret_cast<char*>(datagram.data()), static_cast<int>(datagram.size()), 0,
+			reinterpret_cast<sockaddr*>(&from), &fromLength) <= 0) {
+			std::cerr << "Join benchmark never received the join\n";
+			closesocket(clientSocket); closesocket(serverSocket); WSACleanup(); return;
+		}
+
+		const int64_t encodeStart = NetworkTimeNs();
+		const auto keyframe = EncodeKeyframe(1, encodeStart, 1.0f, 0, static_cast<uint32_t>(bodies.size()), bodies);
+		const int64_t encodeNs = NetworkTimeNs() - encodeStart;
+
+		for (const std::vector<std::byte>& chunk : keyframe->Chunks) {
+			sendto(serverSocket, reinterpret_cast<const char*>(chunk.data()), static_cast<int>(chunk.size()), 0,
+				reinterpret_cast<const sockaddr*>(&from), fromLength);
+		}
+
+		KeyframeAssembly assembly;
+
+		for (const int64_t deadline = start + 1'000'000'000; !KeyframeComplete(assembly) && NetworkTimeNs() < deadline;) {
+			const int size = ReceiveDatagram(clientSocket, datagram);
+			if (size == SOCKET_ERROR) break;
+
+			if (size == 0) {
+				std::this_thread::yield();
+				continue;
+			}
+
+			const auto packet = std::span(datagram).first(size);
+			PacketHeader header;
+			KeyframeMessage message;
+
+			if (!ReadPacketHeader(packet, header) || header.Type != MessageType::Keyframe) continue;
+
+			ByteReader reader = PacketPayload(packet);
+			if (DecodeMessage(reader, message)) AddKeyframeChunk(assembly, message, reader);
+		}
+
+		const int64_t syncNs = NetworkTimeNs() - start;
+
+		std::cout << "Join with " << bodies.size() << " bodies\n"
+			<< "  keyframe " << keyframe->Bytes << " bytes in " << keyframe->Chunks.size() << " chunks, "
+			<< bodies.size() * WireSize<TriangleData>() << " bytes unquantized\n"
+			<< "  encode " << static_cast<double>(encodeNs) / 1e6 << " ms\n";
+
+		if (KeyframeComplete(assembly)) {
+			float maxError = 0.0f;
+			for (size_t i = 0; i < bodies.size(); i++) {
+				maxError = std::max({ maxError, std::abs(bodies[i].SpatialData[0] - assembly.Bodies[i].SpatialData[0]),
+					std::abs(bodies[i].SpatialData[1] - assembly.Bodies[i].SpatialData[1]) });
+			}
+
+			std::cout << "  consistent state after " << static_cast<double>(syncNs) / 1e6 << " ms\n"
+				<< "  max position error " << maxError << " m\n";
+		}
+		else {
+			std::cout << "  incomplete after " << static_cast<double>(syncNs) / 1e6 << " ms, "
+				<< (assembly.Received.empty() ? keyframe->Chunks.size() : assembly.Remaining) << " chunks missing\n";
+		}
+
+		closesocket(clientSocket);
+		closesocket(serverSocket);
+		WSACleanup();
+	}
+
+	void BenchmarkBroadcast(const int rounds) {
+		constexpr int clientCounts[] { 100, 500, 1'000, 5'000 };
+		constexpr unsigned workerCounts[] { 1, 2, 4, 8, 16 };
+
+		if (WSAInit() != 0) return;
+
+		sockaddr_in loopback {};
+		loopback.sin_family = AF_INET;
+		loopback.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+		const auto openSocket = [&loopback]() -> Socket {
+			const Socket s = CreateDatagramSocket();
+			if (s != INVALID_SOCKET && bind(s, reinterpret_cast<const sockaddr*>(&loopback), sizeof(loopback)) == SOCKET_ERROR) {
+				closesocket(s);
+				return INVALID_SOCKET;
+			}
+			return s;
+		};
+
+		// The clients are bound sockets that never read, only the server's side of the broadcast is measured
+		ServerSocket = openSocket();
+		std::vector<Socket> sinks;
+		std::vector<sockaddr_in> addresses;
+
+		while (ServerSocket != INVALID_SOCKET && sinks.size() < static_cast<size_t>(clientCounts[std::size(clientCounts) - 1])) {
+			const Socket sink = openSocket();
+			sockaddr_in address {};
+			int addressLength = sizeof(address);
+
+			if (sink == INVALID_SOCKET) break;
+			sinks.push_back(sink);
+			if (getsockname(sink, reinterpret_cast<sockaddr*>(&address), &addressLength) == SOCKET_ERROR) break;
+			addresses.push_back(address);
+		}
+
+		const auto closeSockets = [&] {
+			for (const Socket sink : sinks) closesocket(sink);
+			if (ServerSocket != INVALID_SOCKET) closesocket(ServerSocket);
+			ServerSocket = INVALID_SOCKET;
+			WSACleanup();
+		};
+
+		if (addresses.size() != static_cast<size_t>(clientCounts[std::size(clientCounts) - 1])) {
+			std::cerr << "Broadcast benchmark could only open " << addresses.size() << " loopback client sockets\n";
+			closeSockets();
+			return;
+		}
+
+		// Same as the listener, every client gets a burst of snapshot chunks per broadcast
+		const int sendBuffer = 4 << 20;
+		setsockopt(ServerSocket, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char*>(&sendBuffer), sizeof(sendBuffer));
+
+		std::cout << "Broadcast of " << COUNT_TRIANGLES << " moving bodies, " << rounds << " broadcasts per run\n";
+
+		uint32_t tick = 0;
+
+		for (const int clients : clientCounts) {
+			for (const unsigned workers : workerCounts) {
+				StartBroadcastWorkers(workers);
+
+				for (int i = 0; i < clients; i++) {
+					BroadcastShard& shard = *BroadcastShards[i % BroadcastShards.size()];
+					Lock lock(shard.ClientsMutex);
+
+					// Already synced, and never timed out during the run
+					ClientConnection& client = shard.Clients[AddressKey(addresses[i])];
+					client.Address = addresses[i];
+					client.NeedsKeyframe = false;
+					client.LastHeardNs = std::numeric_limits<int64_t>::max() / 2;
+				}
+
+				double seconds = 0;
+
+				for (int round = 0; round < rounds; round++) {
+					{
+						Lock lock(TriDataMutex);
+						tick++;
+
+						for (int i = 0; i < COUNT_TRIANGLES; i++) TriData[i].SpatialData[1] = static_cast<float>(tick) * 0.01f;
+						TriDataDirty = ALL_BODIES;
+						TriDataLive = ALL_BODIES;
+						TriDataTick = tick;
+					}
+
+					const auto start = std::chrono::steady_clock::now();
+					BroadcastTriangleData();
+					seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				}
+
+				StopBroadcastWorkers();
+
+				std::cout << "  " << clients << " clients, " << workers << " workers: " << seconds * 1e3 / rounds << " ms per broadcast, "
+					<< static_cast<double>(clients) * rounds / seconds / 1e3 << " k client snapshots per second\n";
+			}
+		}
+
+		closeSockets();
+	}
+
+	void BenchmarkReckoning() {
+		constexpr int ticks = 600;
+		constexpr float tickSeconds = 1.0f / static_cast<float>(SIMULATION_TICK_RATE);
+
+		std::vector<std::vector<TriangleData>> states;
+		SimulateBenchmarkScene(COUNT_TRIANGLES, ticks, [&](const std::span<const TriangleData> bodies) {
+			states.emplace_back(bodies.begin(), bodies.end());
+		});
+
+		std::cout << "Dead reckoning, " << COUNT_TRIANGLES << " bodies over " << ticks << " ticks\n";
+
+		for (const int interval : { 6, 60 }) {
+			for (const float tolerance : { 0.0f, 0.02f, 0.1f, 0.25f }) {
+				// Every body differs from the zeroed state at the first broadcast, after that only changes are candidates
+				std::vector<TriangleData> model(COUNT_TRIANGLES), client(COUNT_TRIANGLES);
+				std::vector<int> clientTick(COUNT_TRIANGLES, 0);
+				std::vector<TriangleData> previous(COUNT_TRIANGLES);
+				BodyMask pending {};
+
+				uint64_t sent = 0;
+				int broadcasts = 0;
+				double errorSum = 0;
+				float errorMax = 0;
+				uint64_t samples = 0;
+
+				for (int tick = 0; tick < ticks; tick++) {
+					const std::vector<TriangleData>& actual = states[tick];
+
+					if (tick % interval == 0) {
+						for (int i = 0; i < COUNT_TRIANGLES; i++) {
+							if (std::memcmp(&previous[i], &actual[i], sizeof(TriangleData)) != 0) SetBodyBit(pending, i);
+						}
+						previous = actual;
+
+						// A zero tolerance sends every change, like a server without reckoning
+						const float seconds = tick == 0 ? 0.0f : static_cast<float>(interval) * tickSeconds;
+						const BodyMask selected = SelectReckonedBodies(model, actual, pending, seconds, tolerance);
+
+						ForEachBodyBit(selected, [&](const int i) {
+							model[i] = client[i] = actual[i];
+							clientTick[i] = tick;
+							sent++;
+						});
+						broadcasts++;
+					}
+
+					for (int i = 0; i < COUNT_TRIANGLES; i++) {
+						TriangleData predicted = client[i];
+						ExtrapolateBody(predicted, static_cast<float>(tick - clientTick[i]) * tickSeconds);
+
+						const float error = ReckoningError(predicted, actual[i]);
+						errorSum += error;
+						errorMax = std::max(errorMax, error);
+						samples++;
+					}
+				}
+
+				const double bodiesPerBroadcast = static_cast<double>(sent) / broadcasts;
+				std::cout << "  every " << interval << " ticks, tolerance " << tolerance << " m: "
+					<< bodiesPerBroadcast << " bodies, " << bodiesPerBroadcast * WireSize<BodyDelta>() << " bytes per broadcast"
+					<< ", error mean " << errorSum / static_cast<double>(samples) << " m, max " << errorMax << " m\n";
+			}
+		}
+	}
+
+	void BenchmarkStep(const int ticks, const int shardCount) {
+		constexpr unsigned threadCounts[] { 1, 2, 4, 8, 16 };
+		constexpr float timeStep = 1.0f / static_cast<float>(SIMULATION_TICK_RATE);
+
+		BuildDefaultScene(ActiveScene);
+
+		std::cout << "Step of " << ActiveScene.Bodies.size() << " bodies over " << ticks << " ticks, "
+			<< (shardCount > 0 ? std::to_string(shardCount) : "one per thread") << " shards\n";
+
+		double baseline = 0;
+
+		for (const unsigned threads : threadCounts) {
+			// The stepping thread helps with the jobs, like the simulation thread does
+			StartJobWorkers(threads - 1);
+
+			const int shards = shardCount > 0 ? shardCount : static_cast<int>(threads);
+			CreateWorldShards(shards, b2Vec2(0, Config.Gravity));
+			CreatePhysicsTriangles();
+
+			double seconds = 0, slowest = 0;
+
+			for (int tick = 0; tick < ticks; tick++) {
+				const auto start = std::chrono::steady_clock::now();
+				StepWorldShards(timeStep, Config.VelocityIterations, Config.PositionIterations);
+				const double stepSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+				seconds += stepSeconds;
+				slowest = std::max(slowest, stepSeconds);
+			}
+
+			DestroyWorldShards();
+			StopJobWorkers();
+
+			if (threads == 1) baseline = seconds;
+
+			std::cout << "  " << threads << " threads, " << shards << " shards: " << seconds * 1e3 / ticks << " ms per step, max "
+				<< slowest * 1e3 << " ms, " << baseline / seconds << "x\n";
+		}
+
+		UnloadScene(ActiveScene);
+	}
+
+	void BenchmarkTransforms(const int bodyCount, const int iterations) {
+		std::minstd_rand random(1);
+		std::uniform_real_distribution<float> position(-ARENA_HALF_EXTENT, ARENA_HALF_EXTENT);
+		std::uniform_real_distribution<float> rotation(-200.0f, 200.0f);
+
+		std::vector<float> x(bodyCount), y(bodyCount), angle(bodyCount);
+		for (int i = 0; i < bodyCount; i++) {
+			x[i] = position(random);
+			y[i] = position(random);
+			angle[i] = rotation(random);
+		}
+
+		// The per-body sequence the render loop ran before the batched kernel, the reference for the others
+		const auto buildLinmath = [&](mat4x4* const out) {
+			for (int i = 0; i < bodyCount; i++) {
+				mat4x4 m;
+				mat4x4_identity(m);
+				mat4x4_translate_in_place(m, x[i], y[i], 0);
+				mat4x4_rotate_Z(m, m, angle[i]);
+				mat4x4_dup(out[i], m);
+			}
+		};
+
+		std::vector<mat4x4> reference(bodyCount), out(bodyCount);
+		buildLinmath(reference.data());
+
+		const auto measure = [&](const char* name, const auto& build) {
+			const auto start = std::chrono::steady_clock::now();
+			for (int iteration = 0; iteration < iterations; iteration++) build(out.data());
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			float maxError = 0.0f;
+			for (int i = 0; i < bodyCount; i++) {
+				for (int column = 0; column < 4; column++) {
+					for (int row = 0; row < 4; row++) maxError = std::max(maxError, std::abs(out[i][column][row] - reference[i][column][row]));
+				}
+			}
+
+			std::cout << "  " << name << ": " << seconds * 1e9 / (static_cast<double>(bodyCount) * iterations) << " ns per body, "
+				<< "max difference to linmath " << maxError << "\n";
+		};
+
+		std::cout << "Instance transforms of " << bodyCount << " bodies, " << iterations << " iterations\n";
+
+		measure("linmath", buildLinmath);
+		measure("scalar", [&](mat4x4* const matrices) { BuildInstanceTransformsScalar(x.data(), y.data(), angle.data(), matrices, bodyCount); });
+		measure("batched", [&](mat4x4* const matrices) { BuildInstanceTransforms(x.data(), y.data(), angle.data(), matrices, bodyCount); });
+	}
+
+	void BenchmarkBodyPool(const int batch, const int ticks) {
+		// Alternate halves of a grid, so each batch lands where the previous one was not
+		const std::vector<TriangleData> grids[2] { BenchmarkGrid(batch, 0.0f, 0.0f, 1.0f), BenchmarkGrid(batch, 0.5f, 0.0f, 1.0f) };
+		const auto spawnState = [&grids](const int tick, const int i) { return grids[tick % 2][i]; };
+
+		const auto measure = [&](const char* name, const auto& despawn, const auto& spawn, b2World& world) {
+			double seconds = 0;
+
+			for (int tick = 0; tick < ticks; tick++) {
+				const auto start = std::chrono::steady_clock::now();
+				despawn();
+				spawn(tick);
+				seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+				world.Step(1.0f / 60.0f, 8, 3);
+			}
+
+			std::cout << "  " << name << ": " << seconds * 1e3 / ticks << " ms per tick, "
+				<< 2.0 * batch * ticks / seconds / 1e6 << " M spawns and despawns per second\n";
+		};
+
+		std::cout << "Spawning and despawning " << batch << " bodies per tick over " << ticks << " ticks\n";
+
+		{
+			// Twice the batch, half of it live and half parked
+			b2World world(b2Vec2(0, -9.81f));
+			std::vector<b2Body*> bodies(2 * batch);
+			std::vector<int> live, free;
+
+			for (int i = 0; i < 2 * batch; i++) {
+				bodies[i] = CreateBenchmarkBody(world, TriangleData {}, 1.0f);
+				ParkBody(bodies[i]);
+				free.push_back(i);
+			}
+
+			measure("pooled", [&] {
+				for (const int slot : live) ParkBody(bodies[slot]);
+				free.insert(free.end(), live.begin(), live.end());
+				live.clear();
+			}, [&](const int tick) {
+				for (int i = 0; i < batch; i++) {
+					const int slot = free.back();
+					free.pop_back();
+					RespawnBody(bodies[slot], spawnState(tick, i));
+					live.push_back(slot);
+				}
+			}, world);
+		}
+
+		{
+			b2World world(b2Vec2(0, -9.81f));
+			std::vector<b2Body*> live;
+
+			measure("create and destroy", [&] {
+				for (b2Body* body : live) world.DestroyBody(body);
+				live.clear();
+			}, [&](const int tick) {
+				for (int i = 0; i < batch; i++) live.push_back(CreateBenchmarkBody(world, spawnState(tick, i), 1.0f));
+			}, world);
+		}
+	}
+
+	void BenchmarkReset(const int bodyCount, const int rounds) {
+		constexpr int settleTicks = 30;
+
+		const int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(bodyCount))));
+		const std::vector<TriangleData> initial = BenchmarkGrid(bodyCount, static_cast<float>(-(columns / 2)), 0.0f, 1.0f);
+
+		const auto measure = [&](const char* name, const auto& reset) {
+			b2World world(b2Vec2(0, -9.81f));
+
+			// The bodies fall onto the ground between resets, so every reset breaks up a pile full of contacts
+			b2BodyDef groundDef;
+			groundDef.position.Set(0, -1.0f);
+			b2PolygonShape groundShape;
+			groundShape.SetAsBox(static_cast<float>(columns), 0.5f);
+			world.CreateBody(&groundDef)->CreateFixture(&groundShape, 0.0f);
+
+			std::vector<b2Body*> bodies(bodyCount);
+			for (int i = 0; i < bodyCount; i++) bodies[i] = CreateBenchmarkBody(world, initial[i], 1.0f);
+
+			double resetSeconds = 0, stepSeconds = 0;
+
+			for (int round = 0; round < rounds; round++) {
+				for (int tick = 0; tick < settleTicks; tick++) world.Step(1.0f / 60.0f, 8, 3);
+
+				const auto resetStart = std::chrono::steady_clock::now();
+				reset(bodies);
+				const auto stepStart = std::chrono::steady_clock::now();
+				world.Step(1.0f / 60.0f, 8, 3);
+				const auto stepEnd = std::chrono::steady_clock::now();
+
+				resetSeconds += std::chrono::duration<double>(stepStart - resetStart).count();
+				stepSeconds += std::chrono::duration<double>(stepEnd - stepStart).count();
+			}
+
+			std::cout << "  " << name << ": reset " << resetSeconds * 1e3 / rounds << " ms, next step "
+				<< stepSeconds * 1e3 / rounds << " ms\n";
+		};
+
+		std::cout << "Resetting " << bodyCount << " bodies after " << settleTicks << " ticks, " << rounds << " rounds\n";
+
+		measure("body by body", [&](const std::vector<b2Body*>& bodies) {
+			for (int i = 0; i < bodyCount; i++) {
+				const auto& [SpatialData, PhysicsData] = initial[i];
+				bodies[i]->SetTransform(b2Vec2(SpatialData[0], SpatialData[1]), SpatialData[2]);
+				bodies[i]->SetLinearVelocity(b2Vec2(PhysicsData[0], PhysicsData[1]));
+				bodies[i]->SetAngularVelocity(PhysicsData[2]);
+				bodies[i]->SetAwake(true);
+			}
+		});
+
+		measure("bulk restore", [&](const std::vector<b2Body*>& bodies) { RestoreBodies(bodies, initial); });
+	}
+}
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include <pch.h>
+#include <NetworkingPhysics.h>
+#include <BodyPool.h>
+
+namespace NetPhysics {
+	void RespawnBody(b2Body* const body, const TriangleData& state) {
+		const auto& [SpatialData, PhysicsData] = state;
+
+		// Placed while still disabled, so the proxies are created once at the new position
+		body->SetTransform(b2Vec2(SpatialData[0], SpatialData[1]), SpatialData[2]);
+		body->SetEnabled(true);
+		body->SetAwake(true);
+		body->SetLinearVelocity(b2Vec2(PhysicsData[0], PhysicsData[1]));
+		body->SetAngularVelocity(PhysicsData[2]);
+	}
+
+	void ParkBody(b2Body* const body) {
+		// Falling asleep clears the velocities, disabling drops the proxies and contacts but keeps the allocations
+		body->SetAwake(false);
+		body->SetEnabled(false);
+		body->SetTransform(b2Vec2(0, BODY_PARKING_Y), 0);
+	}
+
+	void RestoreBodies(const std::span<b2Body* const> bodies, const std::span<const TriangleData> states) {
+		for (b2Body* body : bodies) body->SetEnabled(false);
+
+		// Placed while disabled, so every proxy is created once at its restored pose
+		for (size_t i = 0; i < bodies.size(); i++) RespawnBody(bodies[i], states[i]);
+	}
+
+	void InitBodyPool(int liveCount) {
+		liveCount = std::clamp(liveCount, 0, COUNT_TRIANGLES);
+
+		BodiesLive.fill(0);
+		FreeBodySlots.clear();
+		FreeBodySlots.reserve(COUNT_TRIANGLES);
+
+		// Pushed from the top, so the lowest free slot is reused first
+		for (int i = COUNT_TRIANGLES - 1; i >= 0; i--) {
+			if (i < liveCount) {
+				SetBodyBit(BodiesLive, i);
+				continue;
+			}
+
+			if (Triangles[i] != nullptr) ParkBody(Triangles[i]);
+
+			// Parked bodies are asleep, the next capture still has to pick up their parked state
+			SetBodyBit(TrianglesAwake, i);
+			FreeBodySlots.push_back(i);
+		}
+
+		LiveBodyCount.store(liveCount, std::memory_order::relaxed);
+	}
+
+	int SpawnBodies(const std::span<const TriangleData> states, const std::span<int> slots) {
+		int spawned = 0;
+
+		for (const TriangleData& state : states) {
+			if (FreeBodySlots.empty() || spawned >= static_cast<int>(slots.size())) break;
+
+			const int slot = FreeBodySlots.back();
+			FreeBodySlots.pop_back();
+
+			RespawnBody(Triangles[slot], state);
+			SetBodyBit(BodiesLive, slot);
+			slots[spawned++] = slot;
+		}
+
+		LiveBodyCount.fetch_add(spawned, std::memory_order::relaxed);
+		return spawned;
+	}
+
+	int DespawnBodies(const std::span<const int> slots) {
+		int despawned = 0;
+
+		for (const int slot : slots) {
+			if (slot < 0 || slot >= COUNT_TRIANGLES || !TestBodyBit(BodiesLive, slot)) continue;
+
+			ParkBody(Triangles[slot]);
+			ClearBodyBit(BodiesLive, slot);
+			SetBodyBit(TrianglesAwake, slot);
+			FreeBodySlots.push_back(slot);
+			despawned++;
+		}
+
+		LiveBodyCount.fetch_sub(despawned, std::memory_order::relaxed);
+		return despawned;
+	}
+
+	void ApplyBodyRequests() {
+		const int despawns = DespawnRequests.exchange(0, std::memory_order::acquire);
+		const int spawns = SpawnRequests.exchange(0, std::memory_order::acquire);
+
+		if (despawns > 0) {
+			// The most recently added slots go first
+			std::vector<int> slots;
+			for (int i = COUNT_TRIANGLES - 1; i >= 0 && static_cast<int>(slots.size()) < despawns; i--) {
+				if (TestBodyBit(BodiesLive, i)) slots.push_back(i);
+			}
+
+			DespawnBodies(slots);
+		}
+
+		if (spawns > 0) {
+			// Dropped in along the top of the arena
+			static std::minstd_rand random(1);
+			std::uniform_real_distribution<float> x(1.0f - ARENA_HALF_EXTENT, ARENA_HALF_EXTENT - 1.0f);
+
+			std::vector<TriangleData> states(std::min<size_t>(spawns, FreeBodySlots.size()));
+			for (TriangleData& state : states) state = TriangleData { { x(random), ARENA_HALF_EXTENT - 1.0f, 0 }, { 0, 0, 0 } };
+
+			std::vector<int> slots(states.size());
+			SpawnBodies(states, slots);
+		}
+	}
+
+	void ApplyBodyLiveness(const BodyMask& live) {
+		for (size_t word = 0; word < live.size(); word++) {
+			for (uint64_t bits = live[word] ^ BodiesLive[word]; bits != 0; bits &= bits - 1) {
+				const int i = static_cast<int>(word * 64 + std::countr_zero(bits));
+				if (Triangles[i] != nullptr) Triangles[i]->SetEnabled(TestBodyBit(live, i));
+			}
+		}
+
+		BodiesLive = live;
+
+		int count = 0;
+		for (const uint64_t word : live) count += std::popcount(word);
+		LiveBodyCount.store(count, std::memory_order::relaxed);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,204 @@
+#include <pch.h>
+#include <NetworkingPhysics.h>
+#include <Protocol.h>
+#include <NetworkShim.h>
+#include <ReliableChannel.h>
+#include <Keyframe.h>
+#include <Compression.h>
+#include <Netcode.h>
+#include <BotClient.h>
+
+namespace NetPhysics {
+	bool ValidateSnapshot(const SnapshotState& snapshot) {
+		for (const auto& [SpatialData, PhysicsData] : snapshot.Bodies) {
+			for (int i = 0; i < 3; i++) {
+				if (!std::isfinite(SpatialData[i]) || !std::isfinite(PhysicsData[i])) return false;
+			}
+		}
+
+		return true;
+	}
+
+	void ConsumeSnapshot(BotConnection& bot) {
+		const SnapshotState& header = bot.Server->Latest;
+		const double latencyMs = static_cast<double>(NetworkTimeNs() - header.SendTimeNs) / 1e6;
+
+		// Stale snapshots never reach here, so the gap also counts ones that arrived too late
+		if (bot.Snapshots > 0)
+			bot.MissedSnapshots += header.Sequence - bot.LastSequence - 1;
+
+		bot.LastSequence = header.Sequence;
+		bot.Keyframes = bot.Server->Keyframes;
+		bot.SyncMs = static_cast<double>(bot.Server->SyncDurationNs) / 1e6;
+		bot.Snapshots++;
+		bot.LatencySumMs += latencyMs;
+		bot.LatencyMaxMs = std::max(bot.LatencyMaxMs, latencyMs);
+
+		if (!ValidateSnapshot(bot.Server->Latest)) bot.BadSnapshots++;
+	}
+
+	void BotGroupLoop(BotGroup& group, const RunningFlag& running) {
+		std::vector<WSAPOLLFD> polls;
+		std::vector<size_t> owners;
+		bool rebuild = true;
+
+		while (FlagNotSet(running)) {
+			if (rebuild) {
+				Lock lock(group.Mutex);
+				polls.clear();
+				owners.clear();
+
+				for (size_t i = 0; i < group.Connections.size(); i++) {
+					if (!group.Connections[i].Connected) continue;
+					polls.push_back(WSAPOLLFD { group.Connections[i].Server->Handle, POLLRDNORM, 0 });
+					owners.push_back(i);
+				}
+
+				rebuild = false;
+			}
+
+			if (polls.empty()) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+				continue;
+			}
+
+			if (WSAPoll(polls.data(), static_cast<ULONG>(polls.size()), 10) <= 0) continue;
+
+			Lock lock(group.Mutex);
+
+			for (size_t i = 0; i < polls.size(); i++) {
+				BotConnection& bot = group.Connections[owners[i]];
+
+				// Connections still sending hellos or with messages held in the shim are serviced even without new data
+				if (polls[i].revents == 0 && bot.Server->Synced
+					&& !ShimActive(bot.Server->Inbound) && !ShimActive(bot.Server->Outbound)) continue;
+
+				int rc;
+
+				while ((rc = PollServerConnection(*bot.Server)) == 1) ConsumeSnapshot(bot);
+
+				bot.Bytes = bot.Server->BytesReceived;
+				bot.StaleSnapshots = bot.Server->StaleSnapshots;
+
+				if (rc == SOCKET_ERROR) {
+					closesocket(bot.Server->Handle);
+					bot.Connected = false;
+					rebuild = true;
+				}
+			}
+		}
+	}
+
+	BotTotals SumBotGroups(const std::vector<std::unique_ptr<BotGroup>>& groups) {
+		BotTotals totals;
+
+		for (const auto& group : groups) {
+			Lock lock(group->Mutex);
+
+			for (const BotConnection& bot : group->Connections) {
+				totals.Connected += bot.Connected ? 1 : 0;
+				totals.Snapshots += bot.Snapshots;
+				totals.Bytes += bot.Bytes;
+				totals.MissedSnapshots += bot.MissedSnapshots;
+				totals.BadSnapshots += bot.BadSnapshots;
+				totals.StaleSnapshots += bot.StaleSnapshots;
+				totals.Keyframes += bot.Keyframes;
+				totals.SyncMaxMs = std::max(totals.SyncMaxMs, bot.SyncMs);
+				totals.LatencySumMs += bot.LatencySumMs;
+				totals.LatencyMaxMs = std::max(totals.LatencyMaxMs, bot.LatencyMaxMs);
+			}
+		}
+
+		return totals;
+	}
+
+	bool WriteBotReport(const std::vector<std::unique_ptr<BotGroup>>& groups, const std::string& filename) {
+		std::ofstream out(filename, std::ios::trunc);
+		if (!out) return false;
+
+		out << "bot,connected,snapshots,bytes,missed,stale,bad,latency_avg_ms,latency_max_ms,keyframes,sync_ms\n";
+
+		int index = 0;
+		for (const auto& group : groups) {
+			Lock lock(group->Mutex);
+
+			for (const BotConnection& bot : group->Connections) {
+				const double average = bot.Snapshots > 0 ? bot.LatencySumMs / static_cast<double>(bot.Snapshots) : 0.0;
+				out << index++ << ',' << bot.Connected << ',' << bot.Snapshots << ',' << bot.Bytes << ','
+					<< bot.MissedSnapshots << ',' << bot.StaleSnapshots << ',' << bot.BadSnapshots << ',' << average << ',' << bot.LatencyMaxMs << ','
+					<< bot.Keyframes << ',' << bot.SyncMs << '\n';
+			}
+		}
+
+		return static_cast<bool>(out);
+	}
+
+	int RunBotClients(const RunningFlag& running, const int count, const int threads, const int reportIntervalMs,
+		const std::string& reportFile, const wchar_t* address, const wchar_t* port) {
+		std::vector<std::unique_ptr<BotGroup>> groups;
+
+		for (int i = 0; i < std::max(1, threads); i++) {
+			groups.push_back(std::make_unique<BotGroup>());
+		}
+
+		// Connections are dealt round robin so every thread polls a similar number of sockets
+		int connected = 0;
+
+		for (int i = 0; i < count && FlagNotSet(running); i++) {
+			BotConnection bot;
+			bot.Server = std::make_unique<ServerConnection>();
+			bot.Server->Handle = OpenServerConnection(address, port);
+			bot.Connected = SocketIsValid(bot.Server->Handle);
+			SeedNetworkShim(bot.Server->Outbound, static_cast<uint32_t>(i) * 2);
+			SeedNetworkShim(bot.Server->Inbound, static_cast<uint32_t>(i) * 2 + 1);
+			connected += bot.Connected ? 1 : 0;
+
+			groups[i % groups.size()]->Connections.push_back(std::move(bot));
+		}
+
+		std::cout << "Bots connected: " << connected << " / " << count << "\n";
+
+		for (const auto& group : groups) {
+			group->Thread = std::thread(BotGroupLoop, std::ref(*group), std::cref(running));
+		}
+
+		BotTotals previous;
+		auto last = std::chrono::steady_clock::now();
+
+		while (FlagNotSet(running)) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(reportIntervalMs));
+
+			const auto now = std::chrono::steady_clock::now();
+			const double seconds = std::chrono::duration<double>(now - last).count();
+			const BotTotals totals = SumBotGroups(groups);
+			const uint64_t snapshots = totals.Snapshots - previous.Snapshots;
+			const double latencyMs = snapshots > 0 ? (totals.LatencySumMs - previous.LatencySumMs) / static_cast<double>(snapshots) : 0.0;
+
+			std::cout << "connected " << totals.Connected
+				<< "  snapshots/s " << static_cast<double>(snapshots) / seconds
+				<< "  KiB/s " << static_cast<double>(totals.Bytes - previous.Bytes) / seconds / 1024.0
+				<< "  latency avg " << latencyMs << " ms max " << totals.LatencyMaxMs << " ms"
+				<< "  missed " << totals.MissedSnapshots
+				<< "  stale " << totals.StaleSnapshots
+				<< "  bad " << totals.BadSnapshots
+				<< "  keyframes " << totals.Keyframes << " sync max " << totals.SyncMaxMs << " ms\n";
+
+			previous = totals;
+			last = now;
+		}
+
+		for (const auto& group : groups) {
+			group->Thread.join();
+			for (const BotConnection& bot : group->Connections) {
+				if (bot.Connected) closesocket(bot.Server->Handle);
+			}
+		}
+
+		if (!reportFile.empty() && !WriteBotReport(groups, reportFile)) {
+			std::cerr << "Failed to write bot report " << reportFile << "\n";
+			return -1;
+		}
+
+		return 0;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,176 @@
+#include <pch.h>
+#include <NetworkingPhysics.h>
+#include <Protocol.h>
+#include <Compression.h>
+#include <zdict.h>
+
+namespace NetPhysics {
+	// zstd contexts are not thread safe, every sending and receiving thread keeps its own
+	ZSTD_CCtx* CompressionContext() {
+		thread_local std::unique_ptr<ZSTD_CCtx, ZstdDeleter> context(ZSTD_createCCtx());
+		return context.get();
+	}
+
+	ZSTD_DCtx* DecompressionContext() {
+		thread_local std::unique_ptr<ZSTD_DCtx, ZstdDeleter> context(ZSTD_createDCtx());
+		return context.get();
+	}
+
+	std::unique_ptr<CompressionDictionary> CreateCompressionDictionary(const std::span<const std::byte> data) {
+		auto dictionary = std::make_unique<CompressionDictionary>();
+
+		// Raw content dictionaries have no id and could not be negotiated
+		dictionary->Id = ZDICT_getDictID(data.data(), data.size());
+		if (dictionary->Id == 0) return nullptr;
+
+		dictionary->Compress.reset(ZSTD_createCDict(data.data(), data.size(), COMPRESSION_LEVEL));
+		dictionary->Decompress.reset(ZSTD_createDDict(data.data(), data.size()));
+
+		return dictionary->Compress && dictionary->Decompress ? std::move(dictionary) : nullptr;
+	}
+
+	bool LoadCompressionDictionary(const std::string& filename) {
+		std::ifstream in(filename, std::ios::binary);
+		std::vector<char> data;
+		if (in) data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+		if (data.empty()) {
+			std::cerr << "Failed to read compression dictionary " << filename << "\n";
+			return false;
+		}
+
+		SnapshotDictionary = CreateCompressionDictionary(std::as_bytes(std::span(data)));
+
+		if (SnapshotDictionary == nullptr) {
+			std::cerr << filename << " is not a trained zstd dictionary\n";
+			return false;
+		}
+
+		std::cout << "Loaded compression dictionary " << SnapshotDictionary->Id << "\n";
+		return true;
+	}
+
+	uint8_t CompressionCapabilities() {
+		return COMPRESSION_ZSTD | (SnapshotDictionary != nullptr ? COMPRESSION_DICTIONARY : 0);
+	}
+
+	CompressionMode NegotiateCompression(const uint8_t capabilities, const uint32_t dictionaryId) {
+		if (!CompressionEnabled) return CompressionMode::None;
+
+		if ((capabilities & COMPRESSION_DICTIONARY) != 0 && SnapshotDictionary != nullptr && SnapshotDictionary->Id == dictionaryId)
+			return CompressionMode::ZstdDictionary;
+
+		return (capabilities & COMPRESSION_ZSTD) != 0 ? CompressionMode::Zstd : CompressionMode::None;
+	}
+
+	size_t CompressPayload(const std::span<const std::byte> payload, const std::span<std::byte> out, const CompressionDictionary* dictionary) {
+		const size_t size = dictionary != nullptr
+			? ZSTD_compress_usingCDict(CompressionContext(), out.data(), out.size(), payload.data(), payload.size(), dictionary->Compress.get())
+			: ZSTD_compressCCtx(CompressionContext(), out.data(), out.size(), payload.data(), payload.size(), COMPRESSION_LEVEL);
+
+		return ZSTD_isError(size) ? 0 : size;
+	}
+
+	size_t DecompressPayload(const std::span<const std::byte> frame, const std::span<std::byte> out, const CompressionDictionary* dictionary) {
+		const unsigned dictionaryId = ZSTD_getDictID_fromFrame(frame.data(), frame.size());
+		size_t size;
+
+		if (dictionaryId == 0)
+			size = ZSTD_decompressDCtx(DecompressionContext(), out.data(), out.size(), frame.data(), frame.size());
+		else if (dictionary != nullptr && dictionary->Id == dictionaryId)
+			size = ZSTD_decompress_usingDDict(DecompressionContext(), out.data(), out.size(), frame.data(), frame.size(), dictionary->Decompress.get());
+		else
+			return 0;
+
+		return ZSTD_isError(size) ? 0 : size;
+	}
+
+	bool DecompressTrailing(ByteReader& reader, const std::span<std::byte> scratch) {
+		const size_t size = DecompressPayload(reader.Buffer.subspan(reader.Offset), scratch, SnapshotDictionary.get());
+		if (size == 0) return false;
+
+		reader = ByteReader { scratch.first(size) };
+		return true;
+	}
+
+	// Written by the broadcast thread only
+	std::ofstream SnapshotRecording;
+
+	bool OpenSnapshotRecording(const std::string& filename) {
+		SnapshotRecording.open(filename, std::ios::binary | std::ios::trunc);
+		return SnapshotRecording.is_open();
+	}
+
+	void RecordSnapshotPayload(const std::span<const std::byte> payload) {
+		if (!SnapshotRecording.is_open()) return;
+
+		// Each sample is its little-endian uint32 size followed by the payload
+		std::array<std::byte, sizeof(uint32_t)> size;
+		ByteWriter writer { size };
+		WriteField(writer, static_cast<uint32_t>(payload.size()));
+
+		SnapshotRecording.write(reinterpret_cast<const char*>(size.data()), size.size());
+		SnapshotRecording.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+	}
+
+	void CloseSnapshotRecording() {
+		if (!SnapshotRecording.is_open()) return;
+
+		SnapshotRecording.close();
+		if (SnapshotRecording.fail()) std::cerr << "Failed to write the snapshot recording\n";
+	}
+
+	std::vector<std::byte> TrainDictionary(const std::vector<std::byte>& samples, const std::vector<size_t>& sizes) {
+		std::vector<std::byte> dictionary(COMPRESSION_DICTIONARY_BYTES);
+		const size_t size = ZDICT_trainFromBuffer(dictionary.data(), dictionary.size(), samples.data(), sizes.data(),
+			static_cast<unsigned>(sizes.size()));
+
+		if (ZDICT_isError(size)) {
+			std::cerr << "Dictionary training failed: " << ZDICT_getErrorName(size) << "\n";
+			return {};
+		}
+
+		dictionary.resize(size);
+		return dictionary;
+	}
+
+	bool TrainCompressionDictionary(const std::string& recordingFile, const std::string& dictionaryFile) {
+		std::ifstream in(recordingFile, std::ios::binary);
+		std::vector<std::byte> samples;
+		std::vector<size_t> sizes;
+
+		for (std::array<std::byte, sizeof(uint32_t)> prefix; in.read(reinterpret_cast<char*>(prefix.data()), prefix.size());) {
+			ByteReader reader { prefix };
+			uint32_t size;
+			ReadField(reader, size);
+
+			const size_t start = samples.size();
+			samples.resize(start + size);
+			if (!in.read(reinterpret_cast<char*>(samples.data() + start), size)) break;
+
+			sizes.push_back(size);
+		}
+
+		if (sizes.empty()) {
+			std::cerr << "No snapshots recorded in " << recordingFile << "\n";
+			return false;
+		}
+
+		samples.resize(std::accumulate(sizes.begin(), sizes.end(), size_t { 0 }));
+
+		const std::vector<std::byte> dictionary = TrainDictionary(samples, sizes);
+		if (dictionary.empty()) return false;
+
+		std::ofstream out(dictionaryFile, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(dictionary.data()), static_cast<std::streamsize>(dictionary.size()));
+
+		if (!out) {
+			std::cerr << "Failed to write dictionary " << dictionaryFile << "\n";
+			return false;
+		}
+
+		std::cout << "Trained dictionary " << ZDICT_getDictID(dictionary.data(), dictionary.size()) << " of " << dictionary.size()
+			<< " bytes from " << sizes.size() << " snapshots\n";
+		return true;
+	}
+}
\ No newline at end of file
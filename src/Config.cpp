@@ -0,0 +1,141 @@
+#include <pch.h>
+#include <NetworkingPhysics.h>
+#include <Config.h>
+
+namespace NetPhysics {
+	namespace {
+		constexpr std::string_view CONFIG_KEYS[] = {
+			"address", "port", "send-interval", "bodies", "velocity-iterations", "position-iterations", "gravity",
+			"broadcast-workers"
+		};
+
+		bool ParseInt(const std::string_view text, const int min, const int max, int& value, std::string& error) {
+			const std::string copy(text);
+			char* end = nullptr;
+			const long parsed = strtol(copy.c_str(), &end, 10);
+
+			if (copy.empty() || *end != '\0') {
+				error = "expected an integer";
+				return false;
+			}
+			if (parsed < min || parsed > max) {
+				error = "must be between " + std::to_string(min) + " and " + std::to_string(max);
+				return false;
+			}
+
+			value = static_cast<int>(parsed);
+			return true;
+		}
+
+		bool ParseFloat(const std::string_view text, const float min, const float max, float& value, std::string& error) {
+			const std::string copy(text);
+			char* end = nullptr;
+			const float parsed = strtof(copy.c_str(), &end);
+
+			if (copy.empty() || *end != '\0') {
+				error = "expected a number";
+				return false;
+			}
+			if (!std::isfinite(parsed) || parsed < min || parsed > max) {
+				error = "must be between " + std::to_string(static_cast<int>(min)) + " and " + std::to_string(static_cast<int>(max));
+				return false;
+			}
+
+			value = parsed;
+			return true;
+		}
+	}
+
+	bool SetConfigValue(AppConfig& config, const std::string_view key, const std::string_view value, std::string& error) {
+		if (key == "address") {
+			// Passed to GetAddrInfoW after widening, so only plain ASCII host names and addresses
+			const bool ascii = std::all_of(value.begin(), value.end(), [](const char c) { return c > ' ' && c < 0x7F; });
+			if (value.empty() || !ascii) {
+				error = "expected a host name or address";
+				return false;
+			}
+
+			config.Address = value;
+			return true;
+		}
+
+		if (key == "port") return ParseInt(value, 1, 65535, config.Port, error);
+		if (key == "send-interval") return ParseInt(value, 1, MAX_SEND_INTERVAL_MS, config.SendIntervalMs, error);
+		if (key == "bodies") return ParseInt(value, 0, COUNT_TRIANGLES, config.Bodies, error);
+		if (key == "velocity-iterations") return ParseInt(value, 1, 100, config.VelocityIterations, error);
+		if (key == "position-iterations") return ParseInt(value, 1, 100, config.PositionIterations, error);
+		if (key == "gravity") return ParseFloat(value, -1000.0f, 1000.0f, config.Gravity, error);
+		if (key == "broadcast-workers") return ParseInt(value, 1, 64, config.BroadcastWorkers, error);
+
+		error = "unknown setting";
+		return false;
+	}
+
+	bool LoadConfigFile(const std::string& filename, AppConfig& config) {
+		std::ifstream in(filename);
+		if (!in) {
+			std::cerr << "Failed to read config " << filename << "\n";
+			return false;
+		}
+
+		int lineNumber = 0;
+		for (std::string line; std::getline(in, line);) {
+			lineNumber++;
+
+			std::istringstream tokens(line.substr(0, line.find('#')));
+			std::string key, value, extra;
+			if (!(tokens >> key)) continue;
+
+			std::string error = "expected KEY VALUE";
+			if (!(tokens >> value) || (tokens >> extra) || !SetConfigValue(config, key, value, error)) {
+				std::cerr << filename << ":" << lineNumber << ": " << key << ": " << error << "\n";
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool ParseConfigArgument(int& i, const int argc, char* argv[], AppConfig& config, bool& valid) {
+		const std::string_view arg = argv[i];
+		if (!arg.starts_with('-') || std::find(std::begin(CONFIG_KEYS), std::end(CONFIG_KEYS), arg.substr(1)) == std::end(CONFIG_KEYS))
+			return false;
+
+		if (i + 1 >= argc) {
+			std::cerr << arg << ": expected a value\n";
+			valid = false;
+			return true;
+		}
+
+		std::string error;
+		if (!SetConfigValue(config, arg.substr(1), argv[++i], error)) {
+			std::cerr << arg << " " << argv[i] << ": " << error << "\n";
+			valid = false;
+		}
+		return true;
+	}
+
+	bool ParseIntFlag(int& i, char* argv[], const int min, const int max, int& value) {
+		std::string error;
+		if (ParseInt(argv[++i], min, max, value, error)) return true;
+
+		std::cerr << argv[i - 1] << " " << argv[i] << ": " << error << "\n";
+		return false;
+	}
+
+	bool ParseFloatFlag(int& i, char* argv[], const float min, const float max, float& value) {
+		std::string error;
+		if (ParseFloat(argv[++i], min, max, value, error)) return true;
+
+		std::cerr << argv[i - 1] << " " << argv[i] << ": " << error << "\n";
+		return false;
+	}
+
+	std::wstring ConfigAddress(const AppConfig& config) {
+		return std::wstring(config.Address.begin(), config.Address.end());
+	}
+
+	std::wstring ConfigPort(const AppConfig& config) {
+		return std::to_wstring(config.Port);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include <pch.h>
+#include <NetworkingPhysics.h>
+#include <Protocol.h>
+#include <Transforms.h>
+#include <Simulation.h>
+#include <DeadReckoning.h>
+
+namespace NetPhysics {
+	void ExtrapolateBody(TriangleData& body, const float seconds) {
+		for (int axis = 0; axis < 3; axis++) body.SpatialData[axis] += body.PhysicsData[axis] * seconds;
+	}
+
+	float ReckoningError(const TriangleData& predicted, const TriangleData& actual) {
+		const float dx = actual.SpatialData[0] - predicted.SpatialData[0];
+		const float dy = actual.SpatialData[1] - predicted.SpatialData[1];
+
+		// Box2D angles are unbounded, only the difference modulo a full turn shows
+		const float angle = std::remainder(actual.SpatialData[2] - predicted.SpatialData[2], 2.0f * std::numbers::pi_v<float>);
+
+		return std::sqrt(dx * dx + dy * dy) + std::abs(angle) * RECKONING_ANGLE_LEVER;
+	}
+
+	BodyMask SelectReckonedBodies(const std::span<TriangleData> model, const std::span<const TriangleData> actual, BodyMask& pending,
+		const float seconds, const float tolerance) {
+		for (TriangleData& body : model) ExtrapolateBody(body, seconds);
+
+		BodyMask selected {};
+		ForEachBodyBit(pending, [&](const int i) {
+			if (ReckoningError(model[i], actual[i]) > tolerance) {
+				SetBodyBit(selected, i);
+				ClearBodyBit(pending, i);
+			}
+			// With matching velocities the model moves exactly like the body, a resting body in particular
+			else if (std::memcmp(model[i].PhysicsData, actual[i].PhysicsData, sizeof(actual[i].PhysicsData)) == 0)
+				ClearBodyBit(pending, i);
+		});
+
+		return selected;
+	}
+
+	void SeedExtrapolation() {
+		for (int i = 0; i < COUNT_TRIANGLES; i++) {
+			const auto& pos = Triangles[i]->GetPosition();
+			ReckonBase[i] = TriangleData { { pos.x, pos.y, Triangles[i]->GetAngle() }, { 0, 0, 0 } };
+			ReckonBaseTick[i] = 0;
+		}
+	}
+
+	void RebaseExtrapolation(const std::span<const TriangleData> bodies, const uint32_t tick) {
+		for (int i = 0; i < COUNT_TRIANGLES; i++) {
+			if (std::memcmp(&bodies[i], &ReckonBase[i], sizeof(TriangleData)) == 0) continue;
+
+			ReckonBase[i] = bodies[i];
+			ReckonBaseTick[i] = tick;
+		}
+	}
+
+	void ExtrapolateInstances(const uint32_t tick, float* const x, float* const y, float* const angle) {
+		constexpr float tickSeconds = 1.0f / static_cast<float>(SIMULATION_TICK_RATE);
+
+		for (int i = 0; i < COUNT_TRIANGLES; i++) {
+			TriangleData body = ReckonBase[i];
+			ExtrapolateBody(body, static_cast<float>(tick - ReckonBaseTick[i]) * tickSeconds);
+
+			x[i] = body.SpatialData[0];
+			y[i] = body.SpatialData[1];
+			angle[i] = body.SpatialData[2];
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include <pch.h>
+#include <InstanceStream.h>
+#include <Profiler.h>
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+namespace NetPhysics {
+
+	// glBufferStorage is loaded by hand since it is newer than the GL version the loader is generated for
+	using BufferStorageFunc = void (GLAD_API_PTR*)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+	void CreateInstanceStream(InstanceStream& stream, const GLsizeiptr frameSize) {
+		stream.FrameSize = frameSize;
+
+		glGenBuffers(1, &stream.Buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, stream.Buffer);
+
+		const auto bufferStorage = glfwExtensionSupported("GL_ARB_buffer_storage")
+			? reinterpret_cast<BufferStorageFunc>(glfwGetProcAddress("glBufferStorage"))
+			: nullptr;
+
+		if (bufferStorage && GLAD_GL_VERSION_3_2) {
+			constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			const GLsizeiptr size = frameSize * INSTANCE_STREAM_FRAMES;
+
+			bufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+			stream.Mapped = static_cast<std::byte*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+			stream.Persistent = stream.Mapped != nullptr;
+		}
+
+		if (!stream.Persistent) {
+			// Storage from glBufferStorage is immutable, so fall back with a fresh buffer
+			if (bufferStorage) {
+				glDeleteBuffers(1, &stream.Buffer);
+				glGenBuffers(1, &stream.Buffer);
+				glBindBuffer(GL_ARRAY_BUFFER, stream.Buffer);
+			}
+
+			glBufferData(GL_ARRAY_BUFFER, frameSize, nullptr, GL_STREAM_DRAW);
+		}
+
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	void DestroyInstanceStream(InstanceStream& stream) {
+		for (GLsync& fence : stream.Fences) {
+			if (fence) glDeleteSync(fence);
+			fence = nullptr;
+		}
+
+		if (stream.Persistent) {
+			glBindBuffer(GL_ARRAY_BUFFER, stream.Buffer);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+
+		glDeleteBuffers(1, &stream.Buffer);
+		stream = {};
+	}
+
+	void* BeginInstanceFrame(InstanceStream& stream) {
+		PROFILE_SCOPE(Upload);
+		const int64_t waitStart = ProfileTicks();
+		void* data;
+
+		if (stream.Persistent) {
+			if (GLsync& fence = stream.Fences[stream.Frame]) {
+				while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000) == GL_TIMEOUT_EXPIRED) {}
+				glDeleteSync(fence);
+				fence = nullptr;
+			}
+
+			data = stream.Mapped + stream.FrameSize * stream.Frame;
+		}
+		else {
+			// Orphan the old storage so the driver never has to wait for the GPU to finish with it
+			glBindBuffer(GL_ARRAY_BUFFER, stream.Buffer);
+			glBufferData(GL_ARRAY_BUFFER, stream.FrameSize, nullptr, GL_STREAM_DRAW);
+			data = glMapBufferRange(GL_ARRAY_BUFFER, 0, stream.FrameSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+			stream.Staged = data == nullptr;
+			if (stream.Staged) {
+				stream.Staging.resize(static_cast<size_t>(stream.FrameSize));
+				data = stream.Staging.data();
+			}
+		}
+
+		const int64_t waitEnd = ProfileTicks();
+		RecordProfileSample(ProfileStage::GpuWait, waitStart, waitEnd);
+		stream.FenceWaitMs = static_cast<double>(waitEnd - waitStart) * ProfileNsPerTick / 1e6;
+		return data;
+	}
+
+	GLintptr EndInstanceFrame(InstanceStream& stream) {
+		if (stream.Persistent) return stream.FrameSize * stream.Frame;
+
+		glBindBuffer(GL_ARRAY_BUFFER, stream.Buffer);
+		if (stream.Staged)
+			glBufferSubData(GL_ARRAY_BUFFER, 0, stream.FrameSize, stream.Staging.data());
+		else
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		return 0;
+	}
+
+	void FenceInstanceFrame(InstanceStream& stream) {
+		if (!stream.Persistent) return;
+
+		stream.Fences[stream.Frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		stream.Frame = (stream.Frame + 1) % INSTANCE_STREAM_FRAMES;
+	}
+}
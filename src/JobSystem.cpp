@@ -0,0 +1,115 @@
+#include <pch.h>
+#include <JobSystem.h>
+
+namespace NetPhysics {
+	void StartJobWorkers(const unsigned count) {
+		JobsStopping.clear();
+
+		for (unsigned i = 0; i < count; i++) {
+			JobWorkers.push_back(std::make_unique<JobWorker>());
+		}
+
+		for (unsigned i = 0; i < JobWorkers.size(); i++) {
+			JobWorkers[i]->Thread = std::thread(JobWorkerLoop, i);
+		}
+	}
+
+	void StopJobWorkers() {
+		JobsStopping.test_and_set(std::memory_order::release);
+		JobSignal.fetch_add(1, std::memory_order::release);
+		JobSignal.notify_all();
+
+		for (const auto& worker : JobWorkers) {
+			worker->Thread.join();
+		}
+
+		JobWorkers.clear();
+	}
+
+	void SubmitJob(Job job) {
+		if (JobWorkers.empty()) {
+			job();
+			return;
+		}
+
+		JobWorker& worker = *JobWorkers[NextJobQueue.fetch_add(1, std::memory_order::relaxed) % JobWorkers.size()];
+
+		{
+			Lock lock(worker.QueueMutex);
+			worker.Queue.push_back(std::move(job));
+		}
+
+		JobSignal.fetch_add(1, std::memory_order::release);
+		JobSignal.notify_one();
+	}
+
+	bool TryRunJob(const unsigned preferred) {
+		const auto count = static_cast<unsigned>(JobWorkers.size());
+
+		for (unsigned i = 0; i < count; i++) {
+			JobWorker& worker = *JobWorkers[(preferred + i) % count];
+			Job job;
+
+			{
+				Lock lock(worker.QueueMutex);
+				if (worker.Queue.empty()) continue;
+
+				// Owners take their newest job, thieves the oldest one
+				if (i == 0) {
+					job = std::move(worker.Queue.back());
+					worker.Queue.pop_back();
+				}
+				else {
+					job = std::move(worker.Queue.front());
+					worker.Queue.pop_front();
+				}
+			}
+
+			job();
+			return true;
+		}
+
+		return false;
+	}
+
+	void JobWorkerLoop(const unsigned index) {
+		while (true) {
+			// Read the signal before looking for work so a job queued in between still wakes us
+			const uint32_t signal = JobSignal.load(std::memory_order::acquire);
+
+			if (TryRunJob(index)) continue;
+			if (JobsStopping.test(std::memory_order::acquire)) break;
+
+			JobSignal.wait(signal, std::memory_order::acquire);
+		}
+	}
+
+	void ParallelFor(const int count, const int grain, const std::function<void(int, int)>& body) {
+		const int chunkSize = std::max(1, grain);
+		const int chunks = (count + chunkSize - 1) / chunkSize;
+
+		if (chunks <= 1 || JobWorkers.empty()) {
+			if (count > 0) body(0, count);
+			return;
+		}
+
+		std::atomic<int> remaining = chunks;
+
+		for (int c = 1; c < chunks; c++) {
+			SubmitJob([&body, &remaining, c, chunkSize, count] {
+				body(c * chunkSize, std::min(count, (c + 1) * chunkSize));
+				remaining.fetch_sub(1, std::memory_order::acq_rel);
+			});
+		}
+
+		// The caller runs the first chunk itself, then steals until every chunk has finished
+		body(0, chunkSize);
+		remaining.fetch_sub(1, std::memory_order::acq_rel);
+
+		const unsigned start = NextJobQueue.load(std::memory_order::relaxed);
+
+		while (remaining.load(std::memory_order::acquire) != 0) {
+			if (!TryRunJob(start)) std::this_thread::yield();
+		}
+	}
+}
@@ -0,0 +1,155 @@
+#include <pch.h>
+#include <NetworkingPhysics.h>
+#include <Protocol.h>
+#include <Keyframe.h>
+#include <BodyPool.h>
+
+namespace NetPhysics {
+	int16_t QuantizeSigned(const float value, const float range) {
+		return static_cast<int16_t>(std::lround(std::clamp(value / range, -1.0f, 1.0f) * 32767.0f));
+	}
+
+	float DequantizeSigned(const int16_t value, const float range) {
+		return static_cast<float>(value) * range / 32767.0f;
+	}
+
+	QuantizedPose QuantizePose(const TriangleData& body) {
+		// Box2D angles are unbounded, the orientation only needs them modulo a full turn
+		const float angle = std::remainder(body.SpatialData[2], 2.0f * std::numbers::pi_v<float>);
+
+		return QuantizedPose {
+			QuantizeSigned(body.SpatialData[0], KEYFRAME_POSITION_RANGE),
+			QuantizeSigned(body.SpatialData[1], KEYFRAME_POSITION_RANGE),
+			QuantizeSigned(angle, std::numbers::pi_v<float>)
+		};
+	}
+
+	QuantizedVelocity QuantizeVelocity(const TriangleData& body) {
+		return QuantizedVelocity {
+			QuantizeSigned(body.PhysicsData[0], KEYFRAME_VELOCITY_RANGE),
+			QuantizeSigned(body.PhysicsData[1], KEYFRAME_VELOCITY_RANGE),
+			QuantizeSigned(body.PhysicsData[2], KEYFRAME_VELOCITY_RANGE)
+		};
+	}
+
+	void DequantizeBody(const QuantizedPose& pose, const QuantizedVelocity& velocity, TriangleData& body) {
+		body.SpatialData[0] = DequantizeSigned(pose.X, KEYFRAME_POSITION_RANGE);
+		body.SpatialData[1] = DequantizeSigned(pose.Y, KEYFRAME_POSITION_RANGE);
+		body.SpatialData[2] = DequantizeSigned(pose.Angle, std::numbers::pi_v<float>);
+		body.PhysicsData[0] = DequantizeSigned(velocity.X, KEYFRAME_VELOCITY_RANGE);
+		body.PhysicsData[1] = DequantizeSigned(velocity.Y, KEYFRAME_VELOCITY_RANGE);
+		body.PhysicsData[2] = DequantizeSigned(velocity.Angular, KEYFRAME_VELOCITY_RANGE);
+	}
+
+	std::shared_ptr<const EncodedKeyframe> EncodeKeyframe(const uint32_t sequence, const int64_t sendTimeNs, const float gravity, const uint64_t sceneHash,
+		const uint32_t initialBodies, const std::span<const TriangleData> bodies, const std::span<const uint64_t> live) {
+		auto keyframe = std::make_shared<EncodedKeyframe>();
+		keyframe->Sequence = sequence;
+
+		const size_t chunkCount = std::max<size_t>(1, (bodies.size() + KEYFRAME_CHUNK_BODIES - 1) / KEYFRAME_CHUNK_BODIES);
+		std::array<std::byte, PACKET_HEADER_SIZE + MAX_KEYFRAME_CHUNK_PAYLOAD> packet;
+
+		for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+			const size_t first = chunk * KEYFRAME_CHUNK_BODIES;
+			const auto chunkBodies = bodies.subspan(first, std::min<size_t>(KEYFRAME_CHUNK_BODIES, bodies.size() - first));
+
+			// Pooled bodies are sent as a clear live bit alone, resting bodies, the bulk of a settled scene,
+			// without their zero velocities
+			std::array<uint8_t, (KEYFRAME_CHUNK_BODIES + 7) / 8> alive {};
+			std::array<uint8_t, (KEYFRAME_CHUNK_BODIES + 7) / 8> moving {};
+			std::array<QuantizedVelocity, KEYFRAME_CHUNK_BODIES> velocities;
+
+			for (size_t i = 0; i < chunkBodies.size(); i++) {
+				const size_t body = first + i;
+				if (!live.empty() && (live[body / 64] >> (body % 64) & 1u) == 0) continue;
+
+				alive[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+				velocities[i] = QuantizeVelocity(chunkBodies[i]);
+				if (velocities[i].X != 0 || velocities[i].Y != 0 || velocities[i].Angular != 0)
+					moving[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+			}
+
+			ByteWriter writer { packet };
+			const size_t start = BeginPacket(writer, MessageType::Keyframe);
+
+			WriteField(writer, KeyframeMessage { sequence, sendTimeNs, static_cast<uint32_t>(bodies.size()),
+				static_cast<uint16_t>(chunk), static_cast<uint16_t>(chunkCount), static_cast<uint32_t>(first),
+				static_cast<uint16_t>(chunkBodies.size()), gravity, sceneHash, initialBodies });
+
+			for (size_t i = 0; i < (chunkBodies.size() + 7) / 8; i++) WriteField(writer, alive[i]);
+			for (size_t i = 0; i < (chunkBodies.size() + 7) / 8; i++) WriteField(writer, moving[i]);
+
+			for (size_t i = 0; i < chunkBodies.size(); i++) {
+				if ((alive[i / 8] >> (i % 8) & 1u) == 0) continue;
+
+				WriteField(writer, QuantizePose(chunkBodies[i]));
+				if ((moving[i / 8] >> (i % 8) & 1u) != 0) WriteField(writer, velocities[i]);
+			}
+
+			EndPacket(writer, start);
+			if (writer.Overflow) return nullptr;
+
+			keyframe->Chunks.emplace_back(packet.begin(), packet.begin() + writer.Offset);
+			keyframe->Bytes += writer.Offset;
+		}
+
+		return keyframe;
+	}
+
+	bool AddKeyframeChunk(KeyframeAssembly& assembly, const KeyframeMessage& message, ByteReader& reader) {
+		const size_t chunkCount = (message.BodyCount + KEYFRAME_CHUNK_BODIES - 1) / KEYFRAME_CHUNK_BODIES;
+
+		if (message.ChunkCount != std::max<size_t>(1, chunkCount) || message.ChunkIndex >= message.ChunkCount
+			|| message.FirstBody != static_cast<uint32_t>(message.ChunkIndex) * KEYFRAME_CHUNK_BODIES
+			|| message.ChunkBodies != std::min<uint32_t>(KEYFRAME_CHUNK_BODIES, message.BodyCount - message.FirstBody)) return false;
+
+		if (assembly.Received.size() != message.ChunkCount || assembly.Sequence != message.Sequence
+			|| assembly.Bodies.size() != message.BodyCount) {
+			assembly.Sequence = message.Sequence;
+			assembly.Bodies.assign(message.BodyCount, TriangleData {});
+			assembly.Live.assign((message.BodyCount + 63) / 64, 0);
+			assembly.Received.assign(message.ChunkCount, false);
+			assembly.Remaining = message.ChunkCount;
+		}
+
+		if (assembly.Received[message.ChunkIndex]) return true;
+
+		std::array<uint8_t, (KEYFRAME_CHUNK_BODIES + 7) / 8> alive {};
+		std::array<uint8_t, (KEYFRAME_CHUNK_BODIES + 7) / 8> moving {};
+		for (size_t i = 0; i < (message.ChunkBodies + 7u) / 8; i++) ReadField(reader, alive[i]);
+		for (size_t i = 0; i < (message.ChunkBodies + 7u) / 8; i++) ReadField(reader, moving[i]);
+
+		for (size_t i = 0; i < message.ChunkBodies; i++) {
+			const size_t body = message.FirstBody + i;
+
+			if ((alive[i / 8] >> (i % 8) & 1u) == 0) {
+				assembly.Live[body / 64] &= ~(uint64_t { 1 } << (body % 64));
+				assembly.Bodies[body] = ParkedBody();
+				continue;
+			}
+
+			QuantizedPose pose;
+			QuantizedVelocity velocity {};
+
+			ReadField(reader, pose);
+			if ((moving[i / 8] >> (i % 8) & 1u) != 0) ReadField(reader, velocity);
+
+			assembly.Live[body / 64] |= uint64_t { 1 } << (body % 64);
+			DequantizeBody(pose, velocity, assembly.Bodies[body]);
+		}
+
+		if (reader.Overflow) return false;
+
+		assembly.SendTimeNs = message.SendTimeNs;
+		assembly.Gravity = message.Gravity;
+		assembly.SceneHash = message.SceneHash;
+		assembly.InitialBodies = message.InitialBodies;
+		assembly.Received[message.ChunkIndex] = true;
+		assembly.Remaining--;
+		return true;
+	}
+
+	bool KeyframeComplete(const KeyframeAssembly& assembly) {
+		return !assembly.Received.empty() && assembly.Remaining == 0;
+	}
+}
\ No newline at end of file
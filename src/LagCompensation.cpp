@@ -0,0 +1,154 @@
+#include <pch.h>
+#include <NetworkingPhysics.h>
+#include <Protocol.h>
+#include <Keyframe.h>
+#include <LagCompensation.h>
+#include <JobSystem.h>
+#include <Transforms.h>
+#include <Simulation.h>
+#include <Profiler.h>
+#include <Metrics.h>
+
+namespace NetPhysics {
+	// Sequence of the last input sent by this client, only touched by the render thread
+	uint32_t InputSequence = 0;
+
+	// Tests against the triangle in TriangleVertices, which winds counterclockwise
+	bool PointInTriangle(const float x, const float y) {
+		for (int i = 0; i < 3; i++) {
+			const auto& a = TriangleVertices[i].Position;
+			const auto& b = TriangleVertices[(i + 1) % 3].Position;
+			if ((b[0] - a[0]) * (y - a[1]) - (b[1] - a[1]) * (x - a[0]) < 0) return false;
+		}
+		return true;
+	}
+
+	void ClearRewindHistory() {
+		for (RewindFrame& frame : RewindHistory) frame.Valid = false;
+	}
+
+	void RecordRewindFrame(const uint32_t tick) {
+		RewindFrame& frame = RewindHistory[tick % REWIND_HISTORY_TICKS];
+
+		ParallelFor(COUNT_TRIANGLES, BODIES_PER_JOB, [&frame](const int begin, const int end) {
+			for (int i = begin; i < end; i++) {
+				const auto& pos = Triangles[i]->GetPosition();
+				const float angle = std::remainder(Triangles[i]->GetAngle(), 2.0f * std::numbers::pi_v<float>);
+
+				frame.X[i] = QuantizeSigned(pos.x, KEYFRAME_POSITION_RANGE);
+				frame.Y[i] = QuantizeSigned(pos.y, KEYFRAME_POSITION_RANGE);
+				frame.Angle[i] = QuantizeSigned(angle, std::numbers::pi_v<float>);
+			}
+		});
+
+		frame.Live = BodiesLive;
+		frame.Tick = tick;
+		frame.Valid = true;
+	}
+
+	const RewindFrame* FindRewindFrame(const uint32_t tick) {
+		const uint32_t newest = SimulationTicks.load(std::memory_order::relaxed);
+
+		uint32_t clamped = static_cast<int32_t>(tick - newest) > 0 ? newest : tick;
+		if (newest - clamped >= REWIND_HISTORY_TICKS) clamped = newest - (REWIND_HISTORY_TICKS - 1);
+
+		// A reset empties the history, the closest frame recorded since is the best answer left
+		for (; static_cast<int32_t>(newest - clamped) >= 0; clamped++) {
+			const RewindFrame& frame = RewindHistory[clamped % REWIND_HISTORY_TICKS];
+			if (frame.Valid && frame.Tick == clamped) return &frame;
+		}
+
+		return nullptr;
+	}
+
+	bool QueryRewindFrame(const RewindFrame& frame, const InteractionQuery& query, InteractionHit& hit) {
+		constexpr float positionScale = KEYFRAME_POSITION_RANGE / 32767.0f;
+
+		hit = InteractionHit {};
+		float nearest = INTERACTION_BOUND_RADIUS * INTERACTION_BOUND_RADIUS;
+
+		for (int i = 0; i < COUNT_TRIANGLES; i++) {
+			if (!TestBodyBit(frame.Live, i)) continue;
+
+			const float dx = query.PointX - static_cast<float>(frame.X[i]) * positionScale;
+			const float dy = query.PointY - static_cast<float>(frame.Y[i]) * positionScale;
+
+			// Written so a NaN point from the wire fails the test
+			const float distance = dx * dx + dy * dy;
+			if (!(distance <= nearest)) continue;
+
+			// Into the body's frame, overlapping bodies go to the one whose origin is closest
+			const float angle = DequantizeSigned(frame.Angle[i], std::numbers::pi_v<float>);
+			const float c = std::cos(angle);
+			const float s = std::sin(angle);
+			const float localX = c * dx + s * dy;
+			const float localY = c * dy - s * dx;
+			if (!PointInTriangle(localX, localY)) continue;
+
+			nearest = distance;
+			hit = InteractionHit { i, localX, localY };
+		}
+
+		return hit.Body >= 0;
+	}
+
+	void ApplyPendingInteractions() {
+		std::vector<InteractionQuery> queries;
+		{
+			Lock lock(InteractionsMutex);
+			queries.swap(PendingInteractions);
+		}
+
+		if (queries.empty()) return;
+
+		PROFILE_SCOPE(Rewind);
+		std::vector<InteractionHit> hits(queries.size());
+
+		// The queries only read the history, the impulses go on afterwards in arrival order
+		ParallelFor(static_cast<int>(queries.size()), INTERACTIONS_PER_JOB, [&](const int begin, const int end) {
+			for (int i = begin; i < end; i++) {
+				if (const RewindFrame* frame = FindRewindFrame(queries[i].Tick))
+					QueryRewindFrame(*frame, queries[i], hits[i]);
+			}
+		});
+
+		uint64_t applied = 0;
+		for (size_t i = 0; i < queries.size(); i++) {
+			b2Vec2 impulse { queries[i].ImpulseX, queries[i].ImpulseY };
+			if (hits[i].Body < 0 || !std::isfinite(impulse.x) || !std::isfinite(impulse.y)) continue;
+
+			// The body may have been despawned since the tick the query was resolved at
+			if (!TestBodyBit(BodiesLive, hits[i].Body)) continue;
+
+			if (const float length = impulse.Length(); length > MAX_INTERACTION_IMPULSE)
+				impulse *= MAX_INTERACTION_IMPULSE / length;
+
+			// The hit keeps its place on the body, wherever the body has moved since
+			b2Body* body = Triangles[hits[i].Body];
+			body->ApplyLinearImpulse(impulse, body->GetWorldPoint(b2Vec2 { hits[i].LocalX, hits[i].LocalY }), true);
+			applied++;
+		}
+
+		AddMetric(InteractionsMetric, queries.size());
+		AddMetric(InteractionHitsMetric, applied);
+	}
+
+	void SubmitInteraction(const bool isServer, const float pointX, const float pointY, const float impulseX, const float impulseY) {
+		const uint32_t tick = SimulationTicks.load(std::memory_order::relaxed);
+
+		if (isServer) {
+			QueueInteraction(InteractionQuery { tick, pointX, pointY, impulseX, impulseY });
+			return;
+		}
+
+		const uint32_t ticksSinceView = tick - ViewTick.load(std::memory_order::relaxed);
+		const InputMessage input {
+			++InputSequence, ViewSequence.load(std::memory_order::relaxed),
+			static_cast<uint16_t>(std::min<uint32_t>(ticksSinceView, UINT16_MAX)),
+			pointX, pointY, impulseX, impulseY
+		};
+
+		Lock lock(OutgoingInputsMutex);
+		OutgoingInputs.push_back(input);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include <pch.h>
+#include <NetworkingPhysics.h>
+#include <Protocol.h>
+#include <NetworkShim.h>
+#include <ReliableChannel.h>
+#include <Keyframe.h>
+#include <Compression.h>
+#include <Netcode.h>
+#include <LagCompensation.h>
+#include <DeadReckoning.h>
+#include <Scene.h>
+#include <WorldShards.h>
+#include <Transforms.h>
+#include <Simulation.h>
+#include <MemoryAccounting.h>
+
+namespace NetPhysics {
+	std::vector<MemoryEntry> AccountMemory(const bool isServer) {
+		size_t bodies = 0;
+		size_t broadphase = 0;
+		size_t contacts = 0;
+
+		// Every body in the arena carries exactly one polygon fixture with a single proxy
+		constexpr size_t bodyBytes = Box2DBlockBytes(sizeof(b2Body)) + Box2DBlockBytes(sizeof(b2Fixture))
+			+ Box2DBlockBytes(sizeof(b2PolygonShape)) + Box2DBlockBytes(sizeof(b2FixtureProxy));
+
+		for (const WorldShard& shard : Shards) {
+			if (!shard.World) continue;
+
+			bodies += static_cast<size_t>(shard.World->GetBodyCount()) * bodyBytes;
+
+			// The dynamic tree holds a leaf and an inner node per proxy in a node array grown by doubling
+			const size_t nodes = 2 * static_cast<size_t>(shard.World->GetProxyCount());
+			broadphase += std::bit_ceil(std::max<size_t>(nodes, 16)) * sizeof(b2TreeNode);
+
+			contacts += static_cast<size_t>(shard.World->GetContactCount()) * Box2DBlockBytes(sizeof(b2Contact));
+		}
+
+		std::vector<MemoryEntry> entries {
+			{ "Box2D bodies", bodies },
+			{ "Box2D broadphase", broadphase },
+			{ "Box2D contacts", contacts },
+			{ "Body tables", sizeof(Triangles) + sizeof(TriangleShards) + sizeof(TriData) + sizeof(TriDataDirty) + sizeof(TrianglesAwake) },
+			{ "Shard ghost tables", Shards.size() * sizeof(WorldShard) },
+			{ "Scene", ActiveScene.Bytes },
+			// Left untouched by a headless server, so never committed
+			{ "Render states", Headless ? 0 : sizeof(RenderStates) + sizeof(TriangleInstances) }
+		};
+
+		if (isServer) {
+			// Shared snapshot, its payload in every compression mode and the latest keyframe chunks
+			const size_t payloads = static_cast<size_t>(CompressionMode::Count) * COUNT_TRIANGLES * WireSize<BodyDelta>();
+			const size_t chunks = (COUNT_TRIANGLES + KEYFRAME_CHUNK_BODIES - 1) / KEYFRAME_CHUNK_BODIES;
+			entries.push_back({ "Snapshot encoding", COUNT_TRIANGLES * sizeof(TriangleData) + payloads + chunks * (PACKET_HEADER_SIZE + MAX_KEYFRAME_CHUNK_PAYLOAD) });
+			entries.push_back({ "Rewind history", sizeof(RewindHistory) });
+		}
+		else {
+			entries.push_back({ "Server connection", sizeof(ServerConnection) + COUNT_TRIANGLES * sizeof(TriangleData) });
+			if (ExtrapolationEnabled) entries.push_back({ "Reckoning", sizeof(ReckonBase) + sizeof(ReckonBaseTick) });
+		}
+
+		return entries;
+	}
+
+	void PrintMemoryReport(const bool isServer) {
+		const std::vector<MemoryEntry> entries = AccountMemory(isServer);
+		size_t total = 0;
+
+		std::cout << "Memory for " << COUNT_TRIANGLES << " bodies\n";
+		for (const auto& [subsystem, bytes] : entries) {
+			std::cout << "  " << subsystem << ": " << bytes << " bytes, " << bytes / COUNT_TRIANGLES << " per body\n";
+			total += bytes;
+		}
+
+		std::cout << "  total: " << total << " bytes, " << total / COUNT_TRIANGLES << " per body, "
+			<< (total <= SERVER_MEMORY_BUDGET ? "within" : "over") << " the " << (SERVER_MEMORY_BUDGET >> 20) << " MB budget\n";
+	}
+}
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include <pch.h>
+#include <NetworkingPhysics.h>
+#include <Protocol.h>
+#include <NetworkShim.h>
+#include <ReliableChannel.h>
+#include <Keyframe.h>
+#include <Compression.h>
+#include <Netcode.h>
+#include <Metrics.h>
+
+namespace NetPhysics {
+	std::string FormatMetrics() {
+		std::ostringstream out;
+		out.precision(12);
+
+		for (const MetricCounter* counter : Counters) {
+			out << "# HELP " << counter->Name << " " << counter->Help << "\n"
+				<< "# TYPE " << counter->Name << " counter\n"
+				<< counter->Name << " " << counter->Value.load(std::memory_order::relaxed) << "\n";
+		}
+
+		for (const MetricGauge* gauge : Gauges) {
+			out << "# HELP " << gauge->Name << " " << gauge->Help << "\n"
+				<< "# TYPE " << gauge->Name << " gauge\n"
+				<< gauge->Name << " " << gauge->Value.load(std::memory_order::relaxed) << "\n";
+		}
+
+		for (const MetricHistogram* histogram : Histograms) {
+			out << "# HELP " << histogram->Name << " " << histogram->Help << "\n"
+				<< "# TYPE " << histogram->Name << " histogram\n";
+
+			// Prometheus buckets are cumulative
+			uint64_t cumulative = 0;
+			for (int b = 0; b < METRIC_BUCKETS; b++) {
+				cumulative += histogram->Buckets[b].load(std::memory_order::relaxed);
+				out << histogram->Name << "_bucket{le=\"" << static_cast<double>(histogram->Bounds[b]) * histogram->Scale << "\"} "
+					<< cumulative << "\n";
+			}
+
+			cumulative += histogram->Buckets[METRIC_BUCKETS].load(std::memory_order::relaxed);
+			out << histogram->Name << "_bucket{le=\"+Inf\"} " << cumulative << "\n"
+				<< histogram->Name << "_sum " << static_cast<double>(histogram->Sum.load(std::memory_order::relaxed)) * histogram->Scale << "\n"
+				<< histogram->Name << "_count " << cumulative << "\n";
+		}
+
+		return out.str();
+	}
+
+	bool WriteMetricsFile(const std::string& filename) {
+		// Write beside the target and rename so scrapers never read a partial file
+		const std::string temporary = filename + ".tmp";
+
+		{
+			std::ofstream file(temporary, std::ios::trunc);
+			if (file.fail()) return false;
+			file << FormatMetrics();
+			if (file.fail()) return false;
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporary, filename, error);
+		return !error;
+	}
+
+	void ServeMetricsRequest(const Socket client) {
+		// The request itself is not needed, give the client a moment to send it and drain it
+		char request[1024];
+		for (int attempt = 0; attempt < 20; attempt++) {
+			if (recv(client, request, sizeof(request), 0) > 0) break;
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		}
+
+		const std::string body = FormatMetrics();
+		const std::string response =
+			"HTTP/1.1 200 OK\r\n"
+			"Content-Type: text/plain; version=0.0.4\r\n"
+			"Content-Length: " + std::to_string(body.size()) + "\r\n"
+			"Connection: close\r\n\r\n" + body;
+
+		SetSocketBlockingMode(client, true);
+		send(client, response.data(), static_cast<int>(response.size()), 0);
+		shutdown(client, SD_SEND);
+		closesocket(client);
+	}
+
+	int RunMetricsExporter(const RunningFlag& running, const std::wstring port, const std::string filename, const int intervalMs) {
+		if (WSAInit() != 0) return -1;
+
+		Socket listener = INVALID_SOCKET;
+
+		if (!port.empty()) {
+			AddressInfo* addressInfo;
+
+			if (GetAddressInfo(&addressInfo, L"127.0.0.1", port.c_str()) != 0) {
+				WSACleanup(); return -1;
+			}
+
+			listener = CreateStreamSocket();
+
+			if (!SocketIsValid(listener)
+				|| SetSocketBlockingMode(listener, false) == SOCKET_ERROR
+				|| BindSocketToAddress(listener, addressInfo) == SOCKET_ERROR
+				|| ListenWithSocket(listener) == SOCKET_ERROR) {
+				std::cerr << "Metrics listener could not be started\n";
+				if (SocketIsValid(listener)) closesocket(listener);
+				listener = INVALID_SOCKET;
+			}
+
+			FreeAddrInfo(addressInfo);
+		}
+
+		auto nextWrite = std::chrono::steady_clock::now();
+
+		while (FlagNotSet(running)) {
+			if (SocketIsValid(listener)) {
+				if (const Socket client = TryAccept(listener); SocketIsValid(client))
+					ServeMetricsRequest(client);
+			}
+
+			if (!filename.empty() && std::chrono::steady_clock::now() >= nextWrite) {
+				WriteMetricsFile(filename);
+				nextWrite += std::chrono::milliseconds(intervalMs);
+			}
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		}
+
+		if (SocketIsValid(listener)) closesocket(listener);
+		WSACleanup();
+		return 0;
+	}
+}
@@ -1,8 +1,24 @@
 #include <pch.h>
-#include <Netcode.h>
 #include <NetworkingPhysics.h>
+#include <Protocol.h>
+#include <NetworkShim.h>
+#include <ReliableChannel.h>
+#include <Keyframe.h>
+#include <Compression.h>
+#include <Netcode.h>
+#include <LagCompensation.h>
+#include <DeadReckoning.h>
+#include <BodyPool.h>
+#include <Scene.h>
+#include <Transforms.h>
+#include <Simulation.h>
+#include <Profiler.h>
+#include <Metrics.h>
+#include <Config.h>
 
 namespace NetPhysics {
+	static_assert(MAX_SEND_INTERVAL_MS * 4'000'000LL <= CONNECTION_TIMEOUT_NS);
+
 	int WSAInit() {
 		WSAData data; 
 		return WSAStartup(MAKEWORD(2, 2), &data);
@@ -51,47 +67,947 @@ namespace NetPhysics {
 			nullptr, 0, WSA_FLAG_OVERLAPPED);
 	}
 
-	int SendDataToClient(const Socket client) {
-		if (WSAInit() != 0) return -1;
+	Socket CreateDatagramSocket() {
+		return WSASocket(AF_INET, SOCK_DGRAM, IPPROTO_UDP,
+			nullptr, 0, WSA_FLAG_OVERLAPPED);
+	}
+
+	uint64_t AddressKey(const sockaddr_in& address) {
+		return static_cast<uint64_t>(address.sin_addr.s_addr) << 16 | address.sin_port;
+	}
+
+	// A connected UDP socket, so plain send and receive only ever talk to the server
+	Socket OpenServerConnection(const wchar_t* address, const wchar_t* port) {
+		AddressInfo* addressInfo;
+
+		if (GetAddressInfo(&addressInfo, address, port) != 0) return INVALID_SOCKET;
+
+		const Socket s = CreateDatagramSocket();
+
+		if (s == INVALID_SOCKET) {
+			FreeAddrInfo(addressInfo); return INVALID_SOCKET;
+		}
+
+		if (ConnectToAddress(s, addressInfo) == SOCKET_ERROR) {
+			FreeAddrInfo(addressInfo); closesocket(s); return INVALID_SOCKET;
+		}
+
+		FreeAddrInfo(addressInfo);
+
+		if (SetSocketBlockingMode(s, false) == SOCKET_ERROR) {
+			closesocket(s); return INVALID_SOCKET;
+		}
+
+		return s;
+	}
 
+	int64_t NetworkTimeNs() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	int SendBytes(const Socket s, const char* data, const size_t size) {
 		Buffer dataBuf {
-			sizeof(TriData), reinterpret_cast<CHAR*>(TriData)
+			static_cast<ULONG>(size), const_cast<CHAR*>(data)
 		};
 
 		auto bytesSent = 0ul;
 
-		if (WSASend(client, &dataBuf, 1ul, &bytesSent, 0, nullptr, nullptr) == SOCKET_ERROR) {
-			if (const int err = WSAGetLastError(); err != WSAEWOULDBLOCK) {
-				std::cerr << "Error on SEND: " << err << "\n";
-				std::cerr << "Aborting connection on socket " << client << "\n";
-				closesocket(client);
-				Clients.erase(std::ranges::remove(Clients, client).begin()); // UNSAFE WITH CLIENT LISTENER
+		if (WSASend(s, &dataBuf, 1ul, &bytesSent, 0, nullptr, nullptr) == SOCKET_ERROR) {
+			return WSAGetLastError() == WSAEWOULDBLOCK ? 0 : SOCKET_ERROR;
+		}
+
+		return static_cast<int>(bytesSent);
+	}
+
+	// Returns the datagram size, 0 when none is waiting and SOCKET_ERROR when the socket failed
+	int ReceiveDatagram(const Socket s, const std::span<std::byte> buffer) {
+		Buffer recvBuffer {
+			static_cast<ULONG>(buffer.size()), reinterpret_cast<CHAR*>(buffer.data())
+		};
+
+		auto bytesRecvd = 0ul;
+		auto flags = 0ul;
+
+		if (WSARecv(s, &recvBuffer, 1, &bytesRecvd, &flags, nullptr, nullptr) == SOCKET_ERROR) {
+			// Oversized datagrams are dropped and the ICMP unreachable of a server that is not up yet is ignored
+			const int err = WSAGetLastError();
+			return err == WSAEWOULDBLOCK || err == WSAEMSGSIZE || err == WSAECONNRESET ? 0 : SOCKET_ERROR;
+		}
+
+		return static_cast<int>(bytesRecvd);
+	}
+
+	int FlushShimToSocket(const Socket s, NetworkShim& shim, const int64_t nowNs) {
+		for (const ShimMessage* message; (message = ShimPeek(shim, nowNs)) != nullptr; ShimPop(shim)) {
+			if (SendBytes(s, message->Data.data(), message->Data.size()) == SOCKET_ERROR) return SOCKET_ERROR;
+		}
+
+		return 0;
+	}
+
+	int SendToServer(ServerConnection& server, const std::span<const std::byte> packet) {
+		const auto* data = reinterpret_cast<const char*>(packet.data());
+
+		if (ShimActive(server.Outbound)) {
+			const int64_t now = NetworkTimeNs();
+			ShimSubmit(server.Outbound, ShimDirection::Outbound, data, packet.size(), now);
+			return FlushShimToSocket(server.Handle, server.Outbound, now);
+		}
+
+		return SendBytes(server.Handle, data, packet.size()) == SOCKET_ERROR ? SOCKET_ERROR : 0;
+	}
+
+	// Acks the latest snapshot and the reliable channel, echoTimeNs is zero when no snapshot is being acked
+	int SendChannelAck(ServerConnection& server, const int64_t echoTimeNs) {
+		std::array<std::byte, PACKET_HEADER_SIZE + WireSize<AckMessage>()> packet;
+		const size_t size = EncodePacket(AckMessage { server.LastSequence, echoTimeNs, ChannelMakeAck(server.Channel) }, packet);
+		return SendToServer(server, std::span(packet).first(size));
+	}
+
+	// Control messages arrive on the reliable channel and are applied by the simulation thread
+	void ApplyControlPacket(const std::span<const std::byte> packet) {
+		PacketHeader header;
+		if (!ReadPacketHeader(packet, header)) return;
+
+		ByteReader reader = PacketPayload(packet);
+
+		switch (header.Type) {
+		case MessageType::Gravity: {
+			GravityMessage gravity;
+			if (DecodeMessage(reader, gravity)) GravityModifier.store(gravity.Modifier, std::memory_order::relaxed);
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	int SendJoin(ServerConnection& server, const int64_t nowNs) {
+		if (server.JoinStartNs == 0) server.JoinStartNs = nowNs;
+		server.LastJoinNs = nowNs;
+
+		std::array<std::byte, PACKET_HEADER_SIZE + WireSize<JoinMessage>()> join;
+		return SendToServer(server, std::span(join).first(EncodePacket(JoinMessage { nowNs, CompressionCapabilities(),
+			SnapshotDictionary != nullptr ? SnapshotDictionary->Id : 0 }, join)));
+	}
+
+	// Returns 1 once the assembled keyframe replaced server.Latest
+	int CompleteKeyframe(ServerConnection& server) {
+		KeyframeAssembly& keyframe = server.Keyframe;
+
+		if (keyframe.Bodies.size() != COUNT_TRIANGLES) {
+			std::cerr << "Keyframe holds " << keyframe.Bodies.size() << " bodies, expected " << COUNT_TRIANGLES << "\n";
+			return SOCKET_ERROR;
+		}
+
+		if (ActiveScene.Hash != 0 && keyframe.SceneHash != ActiveScene.Hash) {
+			std::cerr << "Server simulates scene " << std::hex << keyframe.SceneHash << ", this client loaded " << ActiveScene.Hash << std::dec << "\n";
+			return SOCKET_ERROR;
+		}
+
+		std::ranges::copy(keyframe.Bodies, server.Latest.Bodies);
+		std::ranges::copy(keyframe.Live, server.Latest.Live.begin());
+		server.Latest.Sequence = keyframe.Sequence;
+		server.Latest.SendTimeNs = keyframe.SendTimeNs;
+		server.LastSequence = keyframe.Sequence;
+		server.InitialBodies = static_cast<int>(std::min<uint32_t>(keyframe.InitialBodies, COUNT_TRIANGLES));
+		server.Synced = true;
+
+		// World parameters travel with the keyframe, later changes arrive on the reliable channel
+		GravityModifier.store(keyframe.Gravity, std::memory_order::relaxed);
+
+		server.Keyframes++;
+		server.SyncDurationNs = NetworkTimeNs() - server.JoinStartNs;
+		server.JoinStartNs = 0;
+		keyframe.Received.clear();
+		return 1;
+	}
+
+	// Returns 1 when the packet moved server.Latest to a newer sequence
+	int HandleServerPacket(ServerConnection& server, const std::span<const std::byte> packet) {
+		PacketHeader header;
+		if (!ReadPacketHeader(packet, header) || PACKET_HEADER_SIZE + header.Size != packet.size()) return 0;
+
+		server.LastHeardNs = NetworkTimeNs();
+		ByteReader reader = PacketPayload(packet);
+
+		// Asks for a keyframe right away instead of waiting for the join interval
+		const auto resync = [&server] {
+			server.Synced = false;
+			return SendJoin(server, server.LastHeardNs) == SOCKET_ERROR ? SOCKET_ERROR : 0;
+		};
+
+		// Copies a fully decoded state into Latest
+		const auto commit = [&server](const uint32_t sequence, const int64_t sendTimeNs, const BodyMask& live) {
+			std::ranges::copy(server.Pending.Bodies, server.Latest.Bodies);
+			server.Latest.Live = live;
+			server.Latest.Sequence = sequence;
+			server.Latest.SendTimeNs = sendTimeNs;
+			server.LastSequence = sequence;
+		};
+
+		switch (header.Type) {
+		case MessageType::Keyframe: {
+			KeyframeMessage keyframe;
+			if (!DecodeMessage(reader, keyframe)) return 0;
+
+			if (server.Synced && static_cast<int32_t>(keyframe.Sequence - server.LastSequence) <= 0) return 0;
+			if (!AddKeyframeChunk(server.Keyframe, keyframe, reader)) return 0;
+
+			return KeyframeComplete(server.Keyframe) ? CompleteKeyframe(server) : 0;
+		}
+		case MessageType::Snapshot: {
+			SnapshotMessage snapshot;
+			if (!DecodeMessage(reader, snapshot)) return 0;
+
+			ChannelProcessAck(server.Channel, snapshot.Channel);
+
+			// A full snapshot also brings a client that lost a delta back in sync, but only a keyframe carries the world parameters
+			if (server.Keyframes == 0) return 0;
+
+			if (static_cast<int32_t>(snapshot.Sequence - server.LastSequence) <= 0) {
+				if (snapshot.ChunkIndex == 0) server.StaleSnapshots++;
+				return 0;
+			}
+
+			if (!AddSnapshotChunk(server.Assembly, header, snapshot.Sequence, snapshot.ChunkIndex, snapshot.ChunkCount, reader)
+				|| !SnapshotComplete(server.Assembly)) return 0;
+
+			reader = ByteReader { server.Assembly.Payload };
+			if ((header.Flags & PACKET_FLAG_COMPRESSED) != 0 && !DecompressTrailing(reader, server.Decompressed)) return 0;
+
+			// Every slot is live except the pooled ones the snapshot lists
+			BodyMask live = ALL_BODIES;
+			if (!DecodeBodyEvents(reader, snapshot.EventCount, live)) return resync();
+
+			if (!DecodeSnapshotBodies(reader, snapshot, server.Pending.Bodies)) {
+				std::cerr << "Snapshot holds " << snapshot.BodyCount << " bodies, expected " << COUNT_TRIANGLES << "\n";
+				return resync();
+			}
+
+			commit(snapshot.Sequence, snapshot.SendTimeNs, live);
+			server.Synced = true;
+			server.JoinStartNs = 0;
+
+			return SendChannelAck(server, snapshot.SendTimeNs) == SOCKET_ERROR ? SOCKET_ERROR : 1;
+		}
+		case MessageType::Delta: {
+			DeltaMessage delta;
+			if (!DecodeMessage(reader, delta)) return 0;
+
+			ChannelProcessAck(server.Channel, delta.Channel);
+
+			if (!server.Synced) return 0;
+
+			if (static_cast<int32_t>(delta.Sequence - server.LastSequence) <= 0) {
+				if (delta.ChunkIndex == 0) server.StaleSnapshots++;
+				return 0;
+			}
+
+			// A delta was lost, the client no longer holds its baseline
+			if (delta.BaselineSequence != server.LastSequence) return resync();
+
+			// A lost chunk loses the whole delta, the next one then names a baseline the client does not hold
+			if (!AddSnapshotChunk(server.Assembly, header, delta.Sequence, delta.ChunkIndex, delta.ChunkCount, reader)
+				|| !SnapshotComplete(server.Assembly)) return 0;
+
+			reader = ByteReader { server.Assembly.Payload };
+			if ((header.Flags & PACKET_FLAG_COMPRESSED) != 0 && !DecompressTrailing(reader, server.Decompressed)) return 0;
+
+			// The server was reset, the delta holds the bodies that left the initial state since
+			const bool reset = (header.Flags & PACKET_FLAG_RESET) != 0;
+
+			// Without the scene the initial state is unknown, a keyframe brings the client back
+			if (reset && ActiveScene.Hash == 0) return resync();
+
+			// Clients start with every scene body live, the server may have started with fewer
+			BodyMask live = server.Latest.Live;
+			if (reset)
+				SceneInitialState(ActiveScene, server.InitialBodies, server.Pending.Bodies, live);
+			else
+				std::ranges::copy(server.Latest.Bodies, server.Pending.Bodies);
+
+			if (!DecodeBodyEvents(reader, delta.EventCount, live)) return resync();
+
+			if (!DecodeDeltaBodies(reader, delta, server.Pending.Bodies)) {
+				std::cerr << "Delta for " << delta.BodyCount << " bodies, expected " << COUNT_TRIANGLES << "\n";
+				return resync();
 			}
+
+			commit(delta.Sequence, delta.SendTimeNs, live);
+
+			return SendChannelAck(server, delta.SendTimeNs) == SOCKET_ERROR ? SOCKET_ERROR : 1;
 		}
+		case MessageType::Ack: {
+			AckMessage ack;
+			if (!DecodeMessage(reader, ack)) return 0;
 
-		WSACleanup();
+			ChannelProcessAck(server.Channel, ack.Channel);
+			return 0;
+		}
+		case MessageType::Reliable: {
+			if (!ChannelReceive(server.Channel, reader, ApplyControlPacket)) return 0;
+
+			// Acked right away rather than with the next snapshot so the server does not resend
+			return SendChannelAck(server, 0) == SOCKET_ERROR ? SOCKET_ERROR : 0;
+		}
+		case MessageType::Ping: {
+			PingMessage ping;
+			if (!DecodeMessage(reader, ping) || ping.Reply != 0) return 0;
+
+			ping.Reply = 1;
+			std::array<std::byte, PACKET_HEADER_SIZE + WireSize<PingMessage>()> reply;
+			return SendToServer(server, std::span(reply).first(EncodePacket(ping, reply))) == SOCKET_ERROR ? SOCKET_ERROR : 0;
+		}
+		default:
+			return 0;
+		}
+	}
+
+	// Returns 1 when server.Latest moved to a newer sequence, 0 when there is nothing new
+	// and SOCKET_ERROR once the connection is lost
+	int PollServerConnection(ServerConnection& server) {
+		const int64_t now = NetworkTimeNs();
+
+		if (server.LastHeardNs != 0 && now - server.LastHeardNs > CONNECTION_TIMEOUT_NS) {
+			std::cerr << "Server timed out\n";
+			return SOCKET_ERROR;
+		}
+
+		// The server registers clients by address, so the first join also doubles as the connect
+		if (!server.Synced && now - server.LastJoinNs >= JOIN_INTERVAL_NS && SendJoin(server, now) == SOCKET_ERROR)
+			return SOCKET_ERROR;
+
+		if (FlushShimToSocket(server.Handle, server.Outbound, now) == SOCKET_ERROR) return SOCKET_ERROR;
+
+		int rc = 0;
+		ChannelFlush(server.Channel, now, [&](const std::span<const std::byte> packet) {
+			if (SendToServer(server, packet) == SOCKET_ERROR) rc = SOCKET_ERROR;
+		});
+		if (rc == SOCKET_ERROR) return SOCKET_ERROR;
+
+		while (true) {
+			if (!ShimActive(server.Inbound)) {
+				const int size = ReceiveDatagram(server.Handle, server.Buffer);
+				if (size <= 0) return size;
+
+				server.BytesReceived += size;
+				rc = HandleServerPacket(server, std::span(server.Buffer).first(size));
+			}
+			else {
+				int size;
+				while ((size = ReceiveDatagram(server.Handle, server.Buffer)) > 0) {
+					server.BytesReceived += size;
+					ShimSubmit(server.Inbound, ShimDirection::Inbound, reinterpret_cast<const char*>(server.Buffer.data()), size, now);
+				}
+
+				if (size == SOCKET_ERROR) return SOCKET_ERROR;
+
+				const ShimMessage* message = ShimPeek(server.Inbound, now);
+				if (message == nullptr) return 0;
+
+				rc = HandleServerPacket(server, std::as_bytes(std::span(message->Data)));
+				ShimPop(server.Inbound);
+			}
+
+			if (rc != 0) return rc;
+		}
+	}
+
+	void QueueOutgoingInputs(ServerConnection& server) {
+		Lock lock(OutgoingInputsMutex);
+
+		for (const InputMessage& input : OutgoingInputs) {
+			std::array<std::byte, PACKET_HEADER_SIZE + WireSize<InputMessage>()> packet;
+			ChannelQueue(server.Channel, std::span(packet).first(EncodePacket(input, packet)));
+		}
+
+		OutgoingInputs.clear();
+	}
+
+	void RecordAck(const AckMessage& ack) {
+		ObserveMetric(ClientRttMetric, std::max<int64_t>(0, NetworkTimeNs() - ack.EchoTimeNs));
+	}
+
+	// Datagrams the socket cannot take right now are dropped like any other lost packet
+	int SendToClient(ClientConnection& client, const std::span<const std::byte> packet) {
+		const auto* data = reinterpret_cast<const char*>(packet.data());
+
+		if (ShimActive(client.Outbound)) {
+			ShimSubmit(client.Outbound, ShimDirection::Outbound, data, packet.size(), NetworkTimeNs());
+			return 0;
+		}
+
+		const int sent = sendto(ServerSocket, data, static_cast<int>(packet.size()), 0,
+			reinterpret_cast<const sockaddr*>(&client.Address), sizeof(client.Address));
+
+		if (sent == SOCKET_ERROR) {
+			if (WSAGetLastError() != WSAEWOULDBLOCK) AddMetric(SendErrorsMetric);
+			return SOCKET_ERROR;
+		}
+
+		AddMetric(BytesSentMetric, sent);
+		return sent;
+	}
+
+	// Inputs arrive on the reliable channel, the view they name is mapped back to the server tick the client saw
+	void ApplyClientInput(const std::span<const std::byte> packet) {
+		PacketHeader header;
+		if (!ReadPacketHeader(packet, header) || header.Type != MessageType::Input) return;
+
+		ByteReader reader = PacketPayload(packet);
+		InputMessage input;
+		if (!DecodeMessage(reader, input)) return;
+
+		// A view that aged out of the table is far outside the history anyway
+		uint32_t tick;
+		if (FindSnapshotTick(input.ViewSequence, tick)) tick += input.TicksSinceView;
+		else tick = SimulationTicks.load(std::memory_order::relaxed);
+
+		QueueInteraction(InteractionQuery { tick, input.PointX, input.PointY, input.ImpulseX, input.ImpulseY });
+	}
+
+	void HandleClientPacket(ClientConnection& client, const std::span<const std::byte> packet) {
+		PacketHeader header;
+		if (!ReadPacketHeader(packet, header)) return;
+
+		ByteReader reader = PacketPayload(packet);
+
+		switch (header.Type) {
+		case MessageType::Ack: {
+			AckMessage ack;
+			if (!DecodeMessage(reader, ack)) return;
+
+			if (ack.EchoTimeNs != 0) RecordAck(ack);
+			ChannelProcessAck(client.Channel, ack.Channel);
+			break;
+		}
+		case MessageType::Join: {
+			JoinMessage join;
+			if (!DecodeMessage(reader, join)) return;
+
+			// Answered by the shard's worker, which owns the keyframe sends
+			client.Compression = NegotiateCompression(join.Compression, join.DictionaryId);
+			client.NeedsKeyframe = true;
+			break;
+		}
+		case MessageType::Reliable: {
+			if (!ChannelReceive(client.Channel, reader, ApplyClientInput)) return;
+
+			// Acked right away, waiting for the next snapshot would have the client resend every input
+			std::array<std::byte, PACKET_HEADER_SIZE + WireSize<AckMessage>()> ack;
+			SendToClient(client, std::span(ack).first(EncodePacket(AckMessage { 0, 0, ChannelMakeAck(client.Channel) }, ack)));
+			break;
+		}
+		case MessageType::Ping: {
+			PingMessage ping;
+			if (!DecodeMessage(reader, ping) || ping.Reply != 0) return;
+
+			ping.Reply = 1;
+			std::array<std::byte, PACKET_HEADER_SIZE + WireSize<PingMessage>()> reply;
+			SendToClient(client, std::span(reply).first(EncodePacket(ping, reply)));
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	void HandleDatagram(const sockaddr_in& from, const std::span<const std::byte> packet) {
+		PacketHeader header;
+		if (!ReadPacketHeader(packet, header) || PACKET_HEADER_SIZE + header.Size != packet.size()) return;
+
+		const uint64_t key = AddressKey(from);
+
+		// Only a join registers a new address, anything else from an unknown peer is dropped
+		BroadcastShard* shard = FindClientShard(key);
+		if (shard == nullptr && header.Type == MessageType::Join) shard = AddClient(from);
+		if (shard == nullptr) return;
+
+		Lock lock(shard->ClientsMutex);
+
+		// The client may have timed out between the lookup and the lock
+		const auto found = shard->Clients.find(key);
+		if (found == shard->Clients.end()) return;
+
+		ClientConnection& client = found->second;
+		client.LastHeardNs = NetworkTimeNs();
+
+		if (ShimActive(client.Inbound))
+			ShimSubmit(client.Inbound, ShimDirection::Inbound, reinterpret_cast<const char*>(packet.data()), packet.size(), client.LastHeardNs);
+		else
+			HandleClientPacket(client, packet);
+
+		// Joining clients get their keyframe now rather than with the next broadcast
+		if (client.NeedsKeyframe) {
+			shard->Wake.fetch_add(1, std::memory_order::release);
+			shard->Wake.notify_one();
+		}
+	}
+
+	void ApplySnapshot(const SnapshotState& snapshot) {
+		Lock lock(TriDataMutex);
+		std::memcpy(TriData, snapshot.Bodies, sizeof(TriData));
+		ApplyBodyLiveness(snapshot.Live);
+
+		// Extrapolating clients leave Box2D alone, thin clients have none
+		if (ExtrapolationEnabled) {
+			RebaseExtrapolation(TriData, SimulationTicks.load(std::memory_order::relaxed));
+			return;
+		}
+		if (ThinClient) return;
+
+		for (int i = 0; i < COUNT_TRIANGLES; i++) {
+			const auto& [SpatialData, PhysicsData] = TriData[i];
+			Triangles[i]->SetTransform(b2Vec2(SpatialData[0], SpatialData[1]), SpatialData[2]);
+			Triangles[i]->SetLinearVelocity(b2Vec2(PhysicsData[0], PhysicsData[1]));
+			Triangles[i]->SetAngularVelocity(PhysicsData[2]);
+		}
+	}
+
+	// Snapshot shared by all broadcast workers, written only while no shard is sending
+	TriangleData Snapshot[COUNT_TRIANGLES];
+	SnapshotMessage SnapshotHeader {};
+	DeltaMessage DeltaHeader {};
+	bool SnapshotIsDelta = false;
+
+	// Snapshot restarted from the initial state, a delta then carries PACKET_FLAG_RESET
+	bool SnapshotReset = false;
+
+	struct SnapshotPayload {
+		std::array<std::byte, MAX_SNAPSHOT_PAYLOAD> Bytes;
+		size_t Size = 0;
+		uint8_t Flags = 0;
+	};
+
+	// Bodies encoded once per broadcast in every compression mode in use, each client gets its own
+	// header carrying its channel ack in front of the payload for its negotiated mode
+	SnapshotPayload SnapshotPayloads[static_cast<size_t>(CompressionMode::Count)];
+
+	// Bodies that changed in Snapshot since the previous broadcast
+	BodyMask SnapshotDirty;
+
+	// Live slots of Snapshot, and the slots spawned or despawned since the previous broadcast
+	BodyMask SnapshotLive;
+	BodyMask SnapshotEvents;
+
+	// With a reckoning tolerance, Snapshot holds the states clients extrapolate from as of SnapshotTick,
+	// and ReckonPending the bodies that changed without being resent
+	uint32_t SnapshotTick = 0;
+	BodyMask ReckonPending;
+
+	// Held by BroadcastTriangleData while it moves Snapshot to the next broadcast, and by the worker encoding its keyframe
+	std::mutex SnapshotMutex;
+	float SnapshotGravity = 0;
+
+	// Keyframe of the last broadcast, encoded by the first worker with a joining client
+	std::shared_ptr<const EncodedKeyframe> LatestKeyframe;
+
+	// Sends one chunk, returns the bytes sent or SOCKET_ERROR
+	int SendSnapshotChunk(ClientConnection& client, const std::span<const std::byte> prefix, const std::span<const std::byte> bytes) {
+		if (ShimActive(client.Outbound)) {
+			std::array<std::byte, MAX_PACKET_SIZE> packet;
+			std::memcpy(packet.data(), prefix.data(), prefix.size());
+			std::memcpy(packet.data() + prefix.size(), bytes.data(), bytes.size());
+			return SendToClient(client, std::span(packet).first(prefix.size() + bytes.size()));
+		}
+
+		// Gathered into one datagram, so the shared body bytes are never copied per client
+		Buffer buffers[] {
+			{ static_cast<ULONG>(prefix.size()), reinterpret_cast<CHAR*>(const_cast<std::byte*>(prefix.data())) },
+			{ static_cast<ULONG>(bytes.size()), reinterpret_cast<CHAR*>(const_cast<std::byte*>(bytes.data())) }
+		};
+
+		auto bytesSent = 0ul;
+
+		if (WSASendTo(ServerSocket, buffers, 2ul, &bytesSent, 0, reinterpret_cast<const sockaddr*>(&client.Address),
+			sizeof(client.Address), nullptr, nullptr) == SOCKET_ERROR) {
+			if (WSAGetLastError() != WSAEWOULDBLOCK) AddMetric(SendErrorsMetric);
+			return SOCKET_ERROR;
+		}
+
+		AddMetric(BytesSentMetric, bytesSent);
+		return static_cast<int>(bytesSent);
+	}
+
+	int SendSnapshotToClient(ClientConnection& client) {
+		const SnapshotPayload& payload = SnapshotPayloads[static_cast<size_t>(client.Compression)];
+		const uint16_t chunkCount = SnapshotChunkCount(payload.Size);
+		const ChannelAck channel = ChannelMakeAck(client.Channel);
+		size_t clientBytes = 0;
+
+		// The rest of a snapshot that lost a chunk is useless to the client, so a failed chunk ends the send
+		for (uint16_t chunk = 0; chunk < chunkCount; chunk++) {
+			const size_t offset = chunk * SNAPSHOT_CHUNK_BYTES;
+			const auto bytes = std::span(payload.Bytes).subspan(offset, std::min(SNAPSHOT_CHUNK_BYTES, payload.Size - offset));
+
+			std::array<std::byte, PACKET_HEADER_SIZE + std::max(WireSize<SnapshotMessage>(), WireSize<DeltaMessage>())> prefix;
+			size_t prefixSize;
+
+			if (SnapshotIsDelta) {
+				DeltaMessage message = DeltaHeader;
+				message.Channel = channel;
+				message.ChunkIndex = chunk;
+				message.ChunkCount = chunkCount;
+				prefixSize = EncodePacketPrefix(message, bytes.size(), prefix, payload.Flags | (SnapshotReset ? PACKET_FLAG_RESET : 0));
+			}
+			else {
+				SnapshotMessage message = SnapshotHeader;
+				message.Channel = channel;
+				message.ChunkIndex = chunk;
+				message.ChunkCount = chunkCount;
+				prefixSize = EncodePacketPrefix(message, bytes.size(), prefix, payload.Flags);
+			}
+
+			const int sent = SendSnapshotChunk(client, std::span(prefix).first(prefixSize), bytes);
+			if (sent == SOCKET_ERROR) return SOCKET_ERROR;
+			clientBytes += sent;
+		}
+
+		if (!ShimActive(client.Outbound)) ObserveMetric(ClientSendBytesMetric, clientBytes);
 		return 0;
 	}
 
+	std::shared_ptr<const EncodedKeyframe> CurrentKeyframe() {
+		Lock lock(SnapshotMutex);
+
+		// Nothing was broadcast yet, the first broadcast sends the keyframe
+		if (SnapshotHeader.Sequence == 0) return nullptr;
+
+		if (LatestKeyframe == nullptr || LatestKeyframe->Sequence != SnapshotHeader.Sequence) {
+			PROFILE_SCOPE(Keyframe);
+			LatestKeyframe = EncodeKeyframe(SnapshotHeader.Sequence, SnapshotHeader.SendTimeNs, SnapshotGravity, ActiveScene.Hash,
+				static_cast<uint32_t>(InitialBodyCount), Snapshot, SnapshotLive);
+		}
+
+		return LatestKeyframe;
+	}
+
+	void SendKeyframeToClient(ClientConnection& client) {
+		const std::shared_ptr<const EncodedKeyframe> keyframe = CurrentKeyframe();
+		if (keyframe == nullptr) return;
+
+		// Deltas only follow on from the latest broadcast, so a keyframe overtaken by one starts over with the new one
+		if (keyframe != client.Keyframe) {
+			client.Keyframe = keyframe;
+			client.KeyframeChunk = 0;
+		}
+
+		const size_t end = std::min(keyframe->Chunks.size(), client.KeyframeChunk + KEYFRAME_CHUNKS_PER_SERVICE);
+		for (; client.KeyframeChunk < end; client.KeyframeChunk++) SendToClient(client, keyframe->Chunks[client.KeyframeChunk]);
+
+		if (client.KeyframeChunk < keyframe->Chunks.size()) return;
+
+		// A client that lost chunks joins again and is sent the whole keyframe of that time
+		client.NeedsKeyframe = false;
+		client.Keyframe.reset();
+		AddMetric(KeyframesMetric);
+		ObserveMetric(ClientSendBytesMetric, keyframe->Bytes);
+	}
+
+	// Returns false once the client has timed out
+	bool ServiceClient(ClientConnection& client, const int64_t nowNs) {
+		for (const ShimMessage* message; (message = ShimPeek(client.Inbound, nowNs)) != nullptr; ShimPop(client.Inbound)) {
+			HandleClientPacket(client, std::as_bytes(std::span(message->Data)));
+		}
+
+		if (client.NeedsKeyframe) SendKeyframeToClient(client);
+
+		ChannelFlush(client.Channel, nowNs, [&client](const std::span<const std::byte> packet) { SendToClient(client, packet); });
+
+		for (const ShimMessage* message; (message = ShimPeek(client.Outbound, nowNs)) != nullptr; ShimPop(client.Outbound)) {
+			const int sent = sendto(ServerSocket, message->Data.data(), static_cast<int>(message->Data.size()), 0,
+				reinterpret_cast<const sockaddr*>(&client.Address), sizeof(client.Address));
+			if (sent != SOCKET_ERROR) AddMetric(BytesSentMetric, sent);
+		}
+
+		return nowNs - client.LastHeardNs <= CONNECTION_TIMEOUT_NS;
+	}
+
+	// Keyframes in flight, held shim messages and unacked reliable messages need the worker to poll between snapshots
+	bool ShardNeedsService(BroadcastShard& shard) {
+		if (NetworkShimEnabled.load(std::memory_order::relaxed)) return true;
+
+		Lock lock(shard.ClientsMutex);
+		return std::ranges::any_of(shard.Clients, [](const auto& entry) {
+			const ClientConnection& client = entry.second;
+			return client.NeedsKeyframe || !client.Outbound.Queue.empty() || !client.Inbound.Queue.empty() || !ChannelIdle(client.Channel);
+		});
+	}
+
+	void WakeBroadcastWorkers() {
+		for (const auto& shard : BroadcastShards) {
+			shard->Wake.fetch_add(1, std::memory_order::release);
+			shard->Wake.notify_one();
+		}
+	}
+
+	void PinThreadToCore(const unsigned core) {
+		const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+		SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << (core % cores));
+	}
+
+	void BroadcastWorker(BroadcastShard& shard, const unsigned core) {
+		if (WSAInit() != 0) return;
+
+		PinThreadToCore(core);
+
+		uint64_t generation = 0;
+		uint32_t wake = 0;
+
+		while (true) {
+			if (ShardNeedsService(shard))
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			else
+				shard.Wake.wait(wake, std::memory_order::acquire);
+
+			wake = shard.Wake.load(std::memory_order::acquire);
+
+			if (BroadcastStopping.test(std::memory_order::acquire)) break;
+
+			const uint64_t current = SnapshotGeneration.load(std::memory_order::acquire);
+			const bool broadcast = current != generation;
+
+			{
+				Lock lock(shard.ClientsMutex);
+				const int64_t now = NetworkTimeNs();
+
+				for (auto it = shard.Clients.begin(); it != shard.Clients.end();) {
+					ClientConnection& client = it->second;
+					// Clients still waiting for a keyframe have no baseline for the delta
+					if (broadcast && !client.NeedsKeyframe) SendSnapshotToClient(client);
+
+					if (ServiceClient(client, now)) {
+						++it;
+						continue;
+					}
+
+					std::cout << "Client timed out\n";
+					{
+						Lock indexLock(ClientIndexMutex);
+						ClientIndex.erase(it->first);
+					}
+					AddMetric(ClientsMetric, -1);
+					it = shard.Clients.erase(it);
+				}
+			}
+
+			if (broadcast) {
+				generation = current;
+				if (ShardsPending.fetch_sub(1, std::memory_order::acq_rel) == 1)
+					ShardsPending.notify_all();
+			}
+		}
+
+		WSACleanup();
+	}
+
+	void StartBroadcastWorkers(const unsigned count) {
+		BroadcastStopping.clear();
+
+		for (unsigned i = 0; i < std::max(1u, count); i++) {
+			BroadcastShards.push_back(std::make_unique<BroadcastShard>());
+		}
+
+		// Core 0 is left to the render/simulation thread
+		for (unsigned i = 0; i < BroadcastShards.size(); i++) {
+			BroadcastShards[i]->Worker = std::thread(BroadcastWorker, std::ref(*BroadcastShards[i]), i + 1);
+		}
+	}
+
+	void StopBroadcastWorkers() {
+		BroadcastStopping.test_and_set(std::memory_order::release);
+		WakeBroadcastWorkers();
+
+		for (const auto& shard : BroadcastShards) {
+			shard->Worker.join();
+		}
+
+		BroadcastShards.clear();
+		ClientIndex.clear();
+		SetMetric(ClientsMetric, 0);
+	}
+
+	BroadcastShard* FindClientShard(const uint64_t key) {
+		Lock lock(ClientIndexMutex);
+		const auto found = ClientIndex.find(key);
+		return found == ClientIndex.end() ? nullptr : found->second;
+	}
+
+	BroadcastShard* AddClient(const sockaddr_in& address) {
+		// Shards are fixed after startup, so only the shard's client list needs locking
+		BroadcastShard* target = nullptr;
+		size_t fewest = SIZE_MAX;
+
+		for (const auto& shard : BroadcastShards) {
+			Lock lock(shard->ClientsMutex);
+			if (shard->Clients.size() < fewest) {
+				fewest = shard->Clients.size();
+				target = shard.get();
+			}
+		}
+
+		if (target == nullptr) return nullptr;
+
+		const uint64_t key = AddressKey(address);
+
+		Lock lock(target->ClientsMutex);
+		ClientConnection& client = target->Clients[key];
+		client.Address = address;
+		client.LastHeardNs = NetworkTimeNs();
+		SeedNetworkShim(client.Outbound, static_cast<uint32_t>(key) * 2);
+		SeedNetworkShim(client.Inbound, static_cast<uint32_t>(key) * 2 + 1);
+
+		{
+			Lock indexLock(ClientIndexMutex);
+			ClientIndex[key] = target;
+		}
+
+		std::cout << "Client connected!\n";
+		AddMetric(ClientsMetric, 1);
+		return target;
+	}
+
+	size_t ClientCount() {
+		size_t count = 0;
+
+		for (const auto& shard : BroadcastShards) {
+			Lock lock(shard->ClientsMutex);
+			count += shard->Clients.size();
+		}
+
+		return count;
+	}
+
+	void QueueReliableBroadcast(const std::span<const std::byte> packet) {
+		for (const auto& shard : BroadcastShards) {
+			Lock lock(shard->ClientsMutex);
+			for (auto& [key, client] : shard->Clients) ChannelQueue(client.Channel, packet);
+		}
+
+		WakeBroadcastWorkers();
+	}
+
 	int BroadcastTriangleData() {
-		Lock lock(TriDataMutex);
+		if (BroadcastShards.empty()) return -1;
+
+		PROFILE_SCOPE(Broadcast);
+		const auto start = std::chrono::steady_clock::now();
+
+		// A worker encoding the keyframe of the previous broadcast finishes it first
+		std::unique_lock snapshotLock(SnapshotMutex);
+
+		uint32_t captureTick;
+		{
+			Lock lock(TriDataMutex);
+			captureTick = TriDataTick;
+
+			// Clients restore the same initial state on the reset flag, so it becomes the baseline of this delta
+			SnapshotReset = TriDataReset;
+			TriDataReset = false;
+
+			if (SnapshotReset) {
+				std::ranges::copy(InitialTriData, Snapshot);
+				SnapshotLive = InitialLive;
+				ReckonPending.fill(0);
+			}
+
+			if (ReckoningTolerance > 0) {
+				for (size_t word = 0; word < ReckonPending.size(); word++) ReckonPending[word] |= TriDataDirty[word];
+
+				const float seconds = static_cast<float>(captureTick - SnapshotTick) / static_cast<float>(SIMULATION_TICK_RATE);
+				SnapshotDirty = SelectReckonedBodies(Snapshot, TriData, ReckonPending, seconds, ReckoningTolerance);
+			}
+			else
+				SnapshotDirty = TriDataDirty;
+
+			// Liveness was captured with TriData, so a spawned body's state goes out with its spawn event
+			for (size_t word = 0; word < SnapshotLive.size(); word++) {
+				SnapshotEvents[word] = SnapshotLive[word] ^ TriDataLive[word];
+				SnapshotDirty[word] |= SnapshotEvents[word];
+			}
+			SnapshotLive = TriDataLive;
+
+			ForEachBodyBit(SnapshotDirty, [](const int i) { Snapshot[i] = TriData[i]; });
+			TriDataDirty.fill(0);
+		}
+		SnapshotTick = captureTick;
 
-		SendOperations.clear();
+		int dirtyBodies = 0;
+		for (const uint64_t word : SnapshotDirty) dirtyBodies += std::popcount(word);
+		SetMetric(DirtyBodiesMetric, dirtyBodies);
 
-		for (const Socket& client : Clients) {
-			SendOperations.push_back(std::async(SendDataToClient, client));
+		// A full snapshot lists every pooled slot, a delta only the changes
+		BodyMask pooled;
+		int pooledBodies = 0, eventBodies = 0;
+		for (size_t word = 0; word < pooled.size(); word++) {
+			pooled[word] = ALL_BODIES[word] & ~SnapshotLive[word];
+			pooledBodies += std::popcount(pooled[word]);
+			eventBodies += std::popcount(SnapshotEvents[word]);
 		}
 
-		for (const std::future<int>& send : SendOperations) {
-			send.wait();
+		// Deltas chain on the previous broadcast, a full snapshot goes out instead whenever it is smaller
+		const uint32_t sequence = SnapshotHeader.Sequence + 1;
+		const int64_t sendTimeNs = NetworkTimeNs();
+		RecordSnapshotTick(sequence, captureTick);
+
+		SnapshotIsDelta = WireSize<DeltaMessage>() + eventBodies * WireSize<BodyEvent>() + dirtyBodies * WireSize<BodyDelta>()
+			< WireSize<SnapshotMessage>() + pooledBodies * WireSize<BodyEvent>() + COUNT_TRIANGLES * WireSize<TriangleData>();
+
+		SnapshotHeader = SnapshotMessage { sequence, sendTimeNs, COUNT_TRIANGLES, static_cast<uint32_t>(pooledBodies), {} };
+		DeltaHeader = DeltaMessage { sequence, sequence - 1, sendTimeNs, COUNT_TRIANGLES, static_cast<uint32_t>(eventBodies),
+			static_cast<uint32_t>(dirtyBodies), {} };
+		SnapshotGravity = GravityModifier.load(std::memory_order::relaxed);
+
+		// Snapshot only changes again with the next broadcast, keyframes of this one are encoded on demand from here on
+		snapshotLock.unlock();
+
+		SnapshotPayload& raw = SnapshotPayloads[static_cast<size_t>(CompressionMode::None)];
+		const size_t eventBytes = EncodeBodyEvents(SnapshotIsDelta ? SnapshotEvents : pooled, SnapshotLive, raw.Bytes);
+		const auto bodyBytes = std::span(raw.Bytes).subspan(eventBytes);
+		raw.Size = eventBytes + (SnapshotIsDelta
+			? EncodeDeltaBodies(Snapshot, SnapshotDirty, bodyBytes)
+			: EncodeSnapshotBodies(Snapshot, bodyBytes));
+
+		const auto rawBytes = std::span(raw.Bytes).first(raw.Size);
+		RecordSnapshotPayload(rawBytes);
+
+		// Compression sits between encoding and the socket writes, once per mode rather than once per client
+		const auto compress = [&](const CompressionMode mode, const CompressionDictionary* dictionary) {
+			SnapshotPayload& payload = SnapshotPayloads[static_cast<size_t>(mode)];
+			payload.Size = CompressPayload(rawBytes, payload.Bytes, dictionary);
+			payload.Flags = PACKET_FLAG_COMPRESSED;
+
+			// Tiny deltas do not make up for the frame overhead
+			if (payload.Size == 0 || payload.Size >= raw.Size) payload = raw;
+		};
+
+		if (CompressionEnabled) {
+			PROFILE_SCOPE(Compress);
+			compress(CompressionMode::Zstd, nullptr);
+			if (SnapshotDictionary != nullptr) compress(CompressionMode::ZstdDictionary, SnapshotDictionary.get());
+		}
+
+		// Release every shard against the new snapshot and wait until all of them are done with it
+		ShardsPending.store(static_cast<int>(BroadcastShards.size()), std::memory_order::relaxed);
+		SnapshotGeneration.fetch_add(1, std::memory_order::release);
+		WakeBroadcastWorkers();
+
+		for (int pending = ShardsPending.load(std::memory_order::acquire); pending != 0;
+			pending = ShardsPending.load(std::memory_order::acquire)) {
+			ShardsPending.wait(pending, std::memory_order::acquire);
 		}
 
+		AddMetric(SnapshotsMetric);
+		ObserveMetric(BroadcastDurationMetric,
+			std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
 		return 0;
 	}
 
-	void TimedSend(long long ns, const RunningFlag& running) {
+	void TimedSend(const int64_t intervalNs, const RunningFlag& running) {
 		while(FlagNotSet(running)) {
-			std::this_thread::sleep_for(std::chrono::seconds(ns));
+			std::this_thread::sleep_for(std::chrono::nanoseconds(intervalNs));
 			BroadcastTriangleData();
 		}
 	}
@@ -102,37 +1018,39 @@ namespace NetPhysics {
 
 		AddressInfo* addressInfo;
 
-		if (GetAddressInfo(&addressInfo) != 0) return -1;
+		if (GetAddressInfo(&addressInfo, ConfigAddress(Config).c_str(), ConfigPort(Config).c_str()) != 0) return -1;
 
-		const Socket ListenSocket = CreateStreamSocket();
+		const Socket ListenSocket = CreateDatagramSocket();
 
 		if (ListenSocket == INVALID_SOCKET) {
 			FreeAddrInfo(addressInfo); WSACleanup(); return -1;
 		}
 
-		if (SetSocketBlockingMode(ListenSocket, false) == SOCKET_ERROR) {
-			FreeAddrInfo(addressInfo); closesocket(ListenSocket); WSACleanup(); return -1;
-		}
-
 		if (BindSocketToAddress(ListenSocket, addressInfo) == SOCKET_ERROR) {
 			FreeAddrInfo(addressInfo); closesocket(ListenSocket); WSACleanup(); return -1;
 		}
 
-		if (ListenWithSocket(ListenSocket) == SOCKET_ERROR) {
-			FreeAddrInfo(addressInfo); closesocket(ListenSocket); WSACleanup(); return -1;
-		}
-
 		FreeAddrInfo(addressInfo);
 
-		Socket ClientSocket = INVALID_SOCKET;
+		// Blocking receives that wake up regularly to check the running flag
+		const DWORD timeoutMs = 100;
+		setsockopt(ListenSocket, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeoutMs), sizeof(timeoutMs));
+
+		// Large worlds send every client a burst of snapshot chunks per broadcast
+		const int sendBuffer = 4 << 20;
+		setsockopt(ListenSocket, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char*>(&sendBuffer), sizeof(sendBuffer));
+
+		ServerSocket = ListenSocket;
+
+		std::array<std::byte, MAX_PACKET_SIZE> datagram;
+		sockaddr_in from {};
 
 		while (FlagNotSet(running)) {
-			ClientSocket = TryAccept(ListenSocket);
+			int fromLength = sizeof(from);
+			const int size = recvfrom(ListenSocket, reinterpret_cast<char*>(datagram.data()), static_cast<int>(datagram.size()), 0,
+				reinterpret_cast<sockaddr*>(&from), &fromLength);
 
-			if (SocketIsValid(ClientSocket)) {
-				std::cout << "Client connected!\n";
-				Clients.push_back(ClientSocket); // UNSAFE WITH DATA SENDER
-			}
+			if (size > 0) HandleDatagram(from, std::span(datagram).first(size));
 		}
 
 		closesocket(ListenSocket);
@@ -144,49 +1062,46 @@ namespace NetPhysics {
 
 		if (WSAInit() != 0) return -1;
 
-		AddressInfo* addressInfo;
-
-		if (GetAddressInfo(&addressInfo) != 0) return -1;
-
-		const SOCKET ConnectSocket = CreateStreamSocket();
+		const Socket ConnectSocket = OpenServerConnection(ConfigAddress(Config).c_str(), ConfigPort(Config).c_str());
 
 		if (ConnectSocket == INVALID_SOCKET) {
-			FreeAddrInfo(addressInfo); WSACleanup(); return -1;
+			WSACleanup(); return -1;
 		}
 
-		if (ConnectToAddress(ConnectSocket, addressInfo) == SOCKET_ERROR) {
-			int err = WSAGetLastError();
-			FreeAddrInfo(addressInfo); closesocket(ConnectSocket); WSACleanup(); return -1;
-		}
+		// Snapshots of large worlds arrive as a burst of chunks, all of which have to fit until the next poll
+		const int receiveBuffer = 4 << 20;
+		setsockopt(ConnectSocket, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&receiveBuffer), sizeof(receiveBuffer));
 
-		if (SetSocketBlockingMode(ConnectSocket, false) == SOCKET_ERROR) {
-			FreeAddrInfo(addressInfo); closesocket(ConnectSocket); WSACleanup(); return -1;
-		}
+		const auto server = std::make_unique<ServerConnection>();
+		server->Handle = ConnectSocket;
+		SeedNetworkShim(server->Outbound, 0);
+		SeedNetworkShim(server->Inbound, 1);
 
-		FreeAddrInfo(addressInfo);
+		uint64_t keyframes = 0;
 
-		if (ConnectSocket == INVALID_SOCKET) {
-			WSACleanup(); return -1;
-		}
+		while (FlagNotSet(running)) {
+			QueueOutgoingInputs(*server);
+			const int rc = PollServerConnection(*server);
 
-		Buffer recvBuffer {
-			sizeof(TriData), reinterpret_cast<CHAR*>(TriData)
-		};
+			if (rc == SOCKET_ERROR) break;
 
-		auto bytesRecvd = 0ul;
+			if (rc == 0) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				continue;
+			}
 
-		auto flags = 0ul;
+			if (server->Keyframes != keyframes) {
+				keyframes = server->Keyframes;
+				std::cout << "Synced with server in " << static_cast<double>(server->SyncDurationNs) / 1e6 << " ms\n";
+			}
 
-		while (FlagNotSet(running)) {
-			const int rc = WSARecv(ConnectSocket, &recvBuffer, 1, &bytesRecvd, &flags, nullptr, nullptr);
-			if (bytesRecvd > 0 && rc != SOCKET_ERROR && ObjectsInitialized.test(std::memory_order::relaxed)) {
-				Lock lock(TriDataMutex);
-				for (int i = 0; i < COUNT_TRIANGLES; i++) {
-					const auto& [SpatialData, PhysicsData] = TriData[i];
-					Triangles[i]->SetTransform(b2Vec2(SpatialData[0], SpatialData[1]), SpatialData[2]);
-					Triangles[i]->SetLinearVelocity(b2Vec2(PhysicsData[0], PhysicsData[1]));
-					Triangles[i]->SetAngularVelocity(PhysicsData[2]);
-				}
+			if (ObjectsInitialized.test(std::memory_order::relaxed)) {
+				PROFILE_SCOPE(Receive);
+				ApplySnapshot(server->Latest);
+
+				// Inputs name the snapshot on screen and how far the local simulation has run since
+				ViewSequence.store(server->Latest.Sequence, std::memory_order::relaxed);
+				ViewTick.store(SimulationTicks.load(std::memory_order::relaxed), std::memory_order::relaxed);
 			}
 		}
 
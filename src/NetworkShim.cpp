@@ -0,0 +1,137 @@
+#include <pch.h>
+#include <NetworkShim.h>
+
+namespace NetPhysics {
+	bool ConditionsActive(const NetworkConditions& conditions) {
+		return conditions.DelayMs > 0.0f || conditions.JitterMs > 0.0f || conditions.LossPercent > 0.0f
+			|| conditions.DuplicatePercent > 0.0f || conditions.ReorderPercent > 0.0f || conditions.BandwidthKbps > 0;
+	}
+
+	void SetNetworkConditions(const ShimDirection direction, const NetworkConditions& conditions) {
+		Lock lock(NetworkConditionsMutex);
+		ShimConditions[static_cast<size_t>(direction)] = conditions;
+
+		bool enabled = false;
+		for (const NetworkConditions& c : ShimConditions) enabled |= ConditionsActive(c);
+		NetworkShimEnabled.store(enabled, std::memory_order::relaxed);
+	}
+
+	NetworkConditions GetNetworkConditions(const ShimDirection direction) {
+		Lock lock(NetworkConditionsMutex);
+		return ShimConditions[static_cast<size_t>(direction)];
+	}
+
+	void SeedNetworkShim(NetworkShim& shim, const uint32_t stream) {
+		// Each connection draws its own sequence so runs with the same seed replay identically
+		shim.Random.seed(NetworkShimSeed.load(std::memory_order::relaxed) * 2654435761u + stream);
+	}
+
+	bool ShimActive(const NetworkShim& shim) {
+		return NetworkShimEnabled.load(std::memory_order::relaxed) || !shim.Queue.empty();
+	}
+
+	void ShimSubmit(NetworkShim& shim, const ShimDirection direction, const char* data, const size_t size, const int64_t nowNs) {
+		const NetworkConditions conditions = GetNetworkConditions(direction);
+		std::uniform_real_distribution<float> percent(0.0f, 100.0f);
+
+		if (percent(shim.Random) < conditions.LossPercent) return;
+
+		// The link serializes messages one after another, so a capped link also delays everything queued behind
+		int64_t sentNs = nowNs;
+		if (conditions.BandwidthKbps > 0) {
+			shim.LinkFreeNs = std::max(shim.LinkFreeNs, nowNs) + static_cast<int64_t>(size) * 8'000'000 / conditions.BandwidthKbps;
+			sentNs = shim.LinkFreeNs;
+		}
+
+		const int copies = percent(shim.Random) < conditions.DuplicatePercent ? 2 : 1;
+
+		for (int copy = 0; copy < copies; copy++) {
+			int64_t releaseNs = sentNs;
+
+			if (percent(shim.Random) >= conditions.ReorderPercent) {
+				const float jitterMs = std::uniform_real_distribution<float>(-conditions.JitterMs, conditions.JitterMs)(shim.Random);
+				releaseNs += static_cast<int64_t>(std::max(0.0f, conditions.DelayMs + jitterMs) * 1e6f);
+			}
+
+			const auto position = std::upper_bound(shim.Queue.begin(), shim.Queue.end(), releaseNs,
+				[](const int64_t release, const ShimMessage& message) { return release < message.ReleaseNs; });
+			shim.Queue.insert(position, ShimMessage { releaseNs, std::vector<char>(data, data + size) });
+		}
+	}
+
+	const ShimMessage* ShimPeek(const NetworkShim& shim, const int64_t nowNs) {
+		if (shim.Queue.empty() || shim.Queue.front().ReleaseNs > nowNs) return nullptr;
+		return &shim.Queue.front();
+	}
+
+	void ShimPop(NetworkShim& shim) {
+		shim.Queue.pop_front();
+	}
+
+	// -net-* options apply to both directions, -net-out-* and -net-in-* to one of them
+	bool ParseNetworkShimArgument(int& i, const int argc, char* argv[]) {
+		constexpr std::string_view prefix = "-net-";
+		const std::string_view arg = argv[i];
+
+		if (!arg.starts_with(prefix) || i + 1 >= argc) return false;
+
+		std::string_view option = arg.substr(prefix.size());
+
+		if (option == "seed") {
+			NetworkShimSeed.store(static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)), std::memory_order::relaxed);
+			return true;
+		}
+
+		bool directions[] = { true, true };
+		if (option.starts_with("out-")) { directions[1] = false; option.remove_prefix(4); }
+		else if (option.starts_with("in-")) { directions[0] = false; option.remove_prefix(3); }
+
+		const float value = std::max(0.0f, static_cast<float>(atof(argv[i + 1])));
+
+		for (size_t d = 0; d < std::size(directions); d++) {
+			if (!directions[d]) continue;
+
+			const auto direction = static_cast<ShimDirection>(d);
+			NetworkConditions conditions = GetNetworkConditions(direction);
+
+			if (option == "delay") conditions.DelayMs = value;
+			else if (option == "jitter") conditions.JitterMs = value;
+			else if (option == "loss") conditions.LossPercent = std::min(value, 100.0f);
+			else if (option == "dup") conditions.DuplicatePercent = std::min(value, 100.0f);
+			else if (option == "reorder") conditions.ReorderPercent = std::min(value, 100.0f);
+			else if (option == "bandwidth") conditions.BandwidthKbps = static_cast<int>(value);
+			else return false;
+
+			SetNetworkConditions(direction, conditions);
+		}
+
+		i++;
+		return true;
+	}
+
+	void DrawNetworkShimWindow() {
+		ImGui::Begin("Network conditions");
+
+		for (size_t d = 0; d < static_cast<size_t>(ShimDirection::Count); d++) {
+			if (!ImGui::CollapsingHeader(ShimDirectionNames[d], ImGuiTreeNodeFlags_DefaultOpen)) continue;
+
+			const auto direction = static_cast<ShimDirection>(d);
+			NetworkConditions conditions = GetNetworkConditions(direction);
+			bool changed = false;
+
+			ImGui::PushID(static_cast<int>(d));
+			changed |= ImGui::SliderFloat("Delay (ms)", &conditions.DelayMs, 0.0f, 1000.0f);
+			changed |= ImGui::SliderFloat("Jitter (ms)", &conditions.JitterMs, 0.0f, 250.0f);
+			changed |= ImGui::SliderFloat("Loss (%)", &conditions.LossPercent, 0.0f, 100.0f);
+			changed |= ImGui::SliderFloat("Duplicate (%)", &conditions.DuplicatePercent, 0.0f, 100.0f);
+			changed |= ImGui::SliderFloat("Reorder (%)", &conditions.ReorderPercent, 0.0f, 100.0f);
+			changed |= ImGui::SliderInt("Bandwidth (kbps)", &conditions.BandwidthKbps, 0, 100'000);
+			if (ImGui::Button("Clear")) { conditions = NetworkConditions {}; changed = true; }
+			ImGui::PopID();
+
+			if (changed) SetNetworkConditions(direction, conditions);
+		}
+
+		ImGui::End();
+	}
+}
\ No newline at end of file
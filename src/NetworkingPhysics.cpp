@@ -1,87 +1,46 @@
 ﻿#include <pch.h>
 #include <NetworkingPhysics.h>
+#include <JobSystem.h>
+#include <WorldShards.h>
+#include <InstanceStream.h>
+#include <Transforms.h>
+#include <Simulation.h>
+#include <Profiler.h>
+#include <BodyPool.h>
+#include <Scene.h>
+#include <ShaderCache.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 
 namespace NetPhysics {
-	void CreateWorldBounds(const std::unique_ptr<b2World>& world) {
-		// Blank physics body template
-		b2BodyDef bodyDef;
-
-		// wall 1
-		bodyDef.position.Set(0, -7);
-		Walls[0] = world->CreateBody(&bodyDef);
-
-		// wall 2
-		bodyDef.position.Set(0, 7);
-		Walls[1] = world->CreateBody(&bodyDef);
-
-		// wall 3
-		bodyDef.position.Set(7, 0);
-		Walls[2] = world->CreateBody(&bodyDef);
-
-		// wall 4
-		bodyDef.position.Set(-7, 0);
-		Walls[3] = world->CreateBody(&bodyDef);
-
-		// Vertical and horizontal wall shapes
-		b2PolygonShape polygonShapeV;
-		polygonShapeV.SetAsBox(0.5f, 20);
-
-		b2PolygonShape polygonShapeH;
-		polygonShapeH.SetAsBox(20, 0.5f);
-
-		// Attach shapes to bodies and make them have infinite mass
-		Walls[0]->CreateFixture(&polygonShapeH, 0.0f);
-		Walls[1]->CreateFixture(&polygonShapeH, 0.0f);
-		Walls[2]->CreateFixture(&polygonShapeV, 0.0f);
-		Walls[3]->CreateFixture(&polygonShapeV, 0.0f);
-	}
-
-	void CreatePhysicsTriangles(const std::unique_ptr<b2World>& world) {
-
-		// Convert vertices into b2Vec2 array
-		const b2Vec2 triangle[3] {
-			{ TriangleVertices[0].Position[0], TriangleVertices[0].Position[1] },
-			{ TriangleVertices[1].Position[0], TriangleVertices[1].Position[1] },
-			{ TriangleVertices[2].Position[0], TriangleVertices[2].Position[1] }
-		};
-
-		//  Define fixture
-		b2PolygonShape triangleShape;
-		triangleShape.Set(triangle, 3);
-
-		b2FixtureDef fixtureDef;
-		fixtureDef.shape = &triangleShape;
-		fixtureDef.density = 10.0f;
-		fixtureDef.friction = 0.3f;
-		fixtureDef.restitution = 1.0f;
-
-		// Define physics body
-		b2BodyDef dynamicBodyDef;
-		dynamicBodyDef.type = b2_dynamicBody;
-
-		// Create triangle objects
-		for (int i = 0; i < COUNT_TRIANGLES; i++) {
-			dynamicBodyDef.linearVelocity.Set(static_cast<float>(i % 10 - 5), static_cast<float>(i / 10 - 5));
-			dynamicBodyDef.position.Set(static_cast<float>(i % 10 - 5), static_cast<float>(i / 10 - 5));
-
-			Triangles[i] = world->CreateBody(&dynamicBodyDef);
-			Triangles[i]->CreateFixture(&fixtureDef);
-		}
+	void CaptureInitialState(const int liveCount) {
+		InitialBodyCount = SceneInitialState(ActiveScene, liveCount, InitialTriData, InitialLive);
 	}
 
 	void ResetSimulation() {
-		for (int i = 0; i < COUNT_TRIANGLES; i++) {
-			Triangles[i]->SetLinearVelocity(b2Vec2(static_cast<float>(i % 10 - 5), static_cast<float>(i / 10 - 5)));
-			Triangles[i]->SetTransform(b2Vec2(static_cast<float>(i % 10 - 5), static_cast<float>(i / 10 - 5)), 0);
-			Triangles[i]->SetAngularVelocity(0);
-		}
+		// Bodies the scene starts with, grouped by the shard world currently holding them
+		std::vector<std::vector<b2Body*>> shardBodies(Shards.size());
+		std::vector<std::vector<TriangleData>> shardStates(Shards.size());
+
+		ForEachBodyBit(InitialLive, [&](const int i) {
+			shardBodies[TriangleShards[i]].push_back(Triangles[i]);
+			shardStates[TriangleShards[i]].push_back(InitialTriData[i]);
+		});
+
+		// Shard worlds are independent, bodies restored into another shard's strip migrate on the next step
+		ParallelFor(static_cast<int>(Shards.size()), 1, [&](const int begin, const int end) {
+			for (int s = begin; s < end; s++) RestoreBodies(shardBodies[s], shardStates[s]);
+		});
+
+		// Spawned bodies return to the pool
+		InitBodyPool(InitialBodyCount);
+		MarkAllTrianglesChanged();
 	}
 
 	void KeyCallback(GLFWwindow* const window, const int key, const int scancode, const int action, const int mods) {
+		// The bodies belong to the simulation thread, so the reset is applied on its next tick
 		if (key == GLFW_KEY_R && action == GLFW_PRESS) {
-			ResetSimulation();
+			ResetRequested.store(true, std::memory_order::release);
 		}
 	}
 
@@ -122,43 +81,61 @@ namespace NetPhysics {
 	}
 
 	std::string ReadShaderFromFile(const std::string& filename) {
-		const std::ifstream file(filename);
+		std::ifstream file(filename, std::ios::binary);
+		std::error_code error;
+		const uintmax_t size = std::filesystem::file_size(filename, error);
 
-		if (file.fail()) {
+		if (file.fail() || error) {
 			ErrorCallback(-1, ("File " + filename + " not found.").c_str());
 			return "";
 		}
 
-		std::stringstream ss;
-		ss << file.rdbuf();
-
-		return ss.str();
+		// Read in one go rather than streamed through a stringstream
+		std::string text(static_cast<size_t>(size), '\0');
+		file.read(text.data(), static_cast<std::streamsize>(text.size()));
+		return text;
 	}
 
 	GLuint GenerateShaderProgram(const std::string& name) {
-		const auto vertex_text = ReadShaderFromFile(name + ".vert.glsl");
-		const auto fragment_text = ReadShaderFromFile(name + ".frag.glsl");
+		return GenerateShaderProgram(name, name);
+	}
 
-		const auto vt = vertex_text.c_str();
-		const auto ft = fragment_text.c_str();
+	GLuint GenerateShaderProgram(const std::string& vertexName, const std::string& fragmentName) {
+		const auto vertex_text = ReadShaderFromFile(vertexName + ".vert.glsl");
+		const auto fragment_text = ReadShaderFromFile(fragmentName + ".frag.glsl");
+
+		const std::string name = vertexName == fragmentName ? vertexName : vertexName + "." + fragmentName;
+		return BuildShaderProgram(name, vertex_text, fragment_text);
+	}
 
-		const GLuint vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-		glShaderSource(vertex_shader, 1, &vt, nullptr);
-		glCompileShader(vertex_shader);
+	void SetInstanceAttributes(const GLuint& program, const InstanceLayout layout, const GLintptr offset) {
+		if (layout == InstanceLayout::Compact) {
+			// Specify pose attribute, the shader builds the rotation and translation itself
+			const GLint poseLocation = glGetAttribLocation(program, "InstancePose");
 
-		const GLuint fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-		glShaderSource(fragment_shader, 1, &ft, nullptr);
-		glCompileShader(fragment_shader);
+			glEnableVertexAttribArray(poseLocation);
+			glVertexAttribPointer(poseLocation, 3, GL_FLOAT, GL_FALSE,
+				sizeof(vec3), reinterpret_cast<void*>(offset));
 
-		const GLuint program = glCreateProgram();
-		glAttachShader(program, vertex_shader);
-		glAttachShader(program, fragment_shader);
-		glLinkProgram(program);
+			glVertexAttribDivisor(poseLocation, 1);
+			return;
+		}
+
+		// Specify transform matrix attribute for 4 attribute slots
+		const GLint modelLocation = glGetAttribLocation(program, "ModelMatrix");
 
-		return program;
+		for (GLint column = 0; column < 4; column++) {
+			glEnableVertexAttribArray(modelLocation + column);
+			glVertexAttribPointer(modelLocation + column, 4, GL_FLOAT, GL_FALSE,
+				sizeof(mat4x4), reinterpret_cast<void*>(offset + column * sizeof(vec4)));
+
+			// Set divisor for instancing
+			glVertexAttribDivisor(modelLocation + column, 1);
+		}
 	}
 
-	void GenerateTriangleBuffers(const GLuint& program, GLuint& vertexBuffer, GLuint& transformBuffer, GLuint& indexBuffer, GLuint& vertexArray)
+	void GenerateTriangleBuffers(const GLuint& program, GLuint& vertexBuffer, GLuint& indexBuffer, GLuint& vertexArray,
+		const InstanceStream& instances, const InstanceLayout layout)
 	{
 		// Generate and bind VAO
 		glGenVertexArrays(1, &vertexArray);
@@ -182,35 +159,9 @@ namespace NetPhysics {
 		glVertexAttribPointer(colLocation, 3, GL_FLOAT, GL_FALSE,
 			sizeof(Vertex), reinterpret_cast<void*>(sizeof(vec2)));
 
-		// Generate and bind instancing transform buffer
-		glGenBuffers(1, &transformBuffer);
-		glBindBuffer(GL_ARRAY_BUFFER, transformBuffer);
-		glBufferData(GL_ARRAY_BUFFER, COUNT_TRIANGLES * sizeof(mat4x4), TriangleTransforms, GL_DYNAMIC_DRAW);
-
-		// Specify transform matrix attribute for 4 attribute slots
-		const GLint modelLocation = glGetAttribLocation(program, "ModelMatrix");
-
-		glEnableVertexAttribArray(modelLocation);
-		glVertexAttribPointer(modelLocation, 4, GL_FLOAT, GL_FALSE,
-			sizeof(mat4x4), static_cast<void*>(nullptr));
-
-		glEnableVertexAttribArray(modelLocation + 1);
-		glVertexAttribPointer(modelLocation + 1, 4, GL_FLOAT, GL_FALSE,
-			sizeof(mat4x4), reinterpret_cast<void*>(1 * sizeof(vec4)));
-
-		glEnableVertexAttribArray(modelLocation + 2);
-		glVertexAttribPointer(modelLocation + 2, 4, GL_FLOAT, GL_FALSE,
-			sizeof(mat4x4), reinterpret_cast<void*>(2 * sizeof(vec4)));
-
-		glEnableVertexAttribArray(modelLocation + 3);
-		glVertexAttribPointer(modelLocation + 3, 4, GL_FLOAT, GL_FALSE,
-			sizeof(mat4x4), reinterpret_cast<void*>(3 * sizeof(vec4)));
-
-		// Set divisors for instancing
-		glVertexAttribDivisor(modelLocation, 1);
-		glVertexAttribDivisor(modelLocation + 1, 1);
-		glVertexAttribDivisor(modelLocation + 2, 1);
-		glVertexAttribDivisor(modelLocation + 3, 1);
+		// Bind instancing buffer and specify its attributes
+		glBindBuffer(GL_ARRAY_BUFFER, instances.Buffer);
+		SetInstanceAttributes(program, layout, 0);
 
 		// Generate and bind index buffer
 		glGenBuffers(1, &indexBuffer);
@@ -223,22 +174,59 @@ namespace NetPhysics {
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	}
 
-	void CollectTriangleData() {
+	size_t InstanceDataSize(const InstanceLayout layout) {
+		return COUNT_TRIANGLES * (layout == InstanceLayout::Compact ? sizeof(vec3) : sizeof(mat4x4));
+	}
+
+	void MarkAllTrianglesChanged() {
+		TrianglesAwake.fill(~uint64_t { 0 });
+	}
+
+	void ResetTriangleData() {
+		Lock lock(TriDataMutex);
+		std::memcpy(TriData, InitialTriData, sizeof(TriData));
+		TriDataDirty.fill(0);
+		TriDataLive = InitialLive;
+		TriDataReset = true;
+	}
+
+	void CollectTriangleData(const uint32_t tick) {
+		PROFILE_SCOPE(Capture);
+
 		if (TriDataMutex.try_lock()) {
-			for(int i = 0; i < COUNT_TRIANGLES; i++) {
-				const auto pos = Triangles[i]->GetPosition();
-				const auto vel = Triangles[i]->GetLinearVelocity();
-				const auto angle = Triangles[i]->GetAngle();
-				const auto angularVel = Triangles[i]->GetAngularVelocity();
-
-				TriData[i].SpatialData[0] = pos.x;
-				TriData[i].SpatialData[1] = pos.y;
-				TriData[i].SpatialData[2] = angle;
-
-				TriData[i].PhysicsData[0] = vel.x;
-				TriData[i].PhysicsData[1] = vel.y;
-				TriData[i].PhysicsData[2] = angularVel;
-			}
+			ParallelFor(COUNT_TRIANGLES, BODIES_PER_JOB, [](const int begin, const int end) {
+				// Chunks start on a word boundary, so whole mask words belong to this job
+				for (int word = begin >> 6; word <= (end - 1) >> 6; word++) {
+					uint64_t awakeBits = 0;
+
+					for (int i = word * 64; i < std::min(end, (word + 1) * 64); i++) {
+						const bool awake = Triangles[i]->IsAwake();
+						awakeBits |= static_cast<uint64_t>(awake) << (i & 63);
+
+						// A body that falls asleep is captured once more to send its resting state
+						if (!awake && !TestBodyBit(TrianglesAwake, i)) continue;
+
+						const auto pos = Triangles[i]->GetPosition();
+						const auto vel = Triangles[i]->GetLinearVelocity();
+						const auto angle = Triangles[i]->GetAngle();
+						const auto angularVel = Triangles[i]->GetAngularVelocity();
+
+						const TriangleData data {
+							{ pos.x, pos.y, angle },
+							{ vel.x, vel.y, angularVel }
+						};
+
+						if (std::memcmp(&data, &TriData[i], sizeof(TriangleData)) != 0) {
+							TriData[i] = data;
+							SetBodyBit(TriDataDirty, i);
+						}
+					}
+
+					TrianglesAwake[word] = awakeBits;
+				}
+			});
+			TriDataTick = tick;
+			TriDataLive = BodiesLive;
 			TriDataMutex.unlock();
 		}
 	}
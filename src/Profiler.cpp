@@ -0,0 +1,220 @@
+#include <pch.h>
+#include <Profiler.h>
+
+namespace NetPhysics {
+	double CalibrateProfileTicks() {
+#ifdef NETPHYSICS_PROFILE_TSC
+		const auto clockStart = std::chrono::steady_clock::now();
+		const int64_t tickStart = ProfileTicks();
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+		const int64_t ticks = ProfileTicks() - tickStart;
+		const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - clockStart).count();
+		return ticks > 0 ? ns / static_cast<double>(ticks) : 1.0;
+#else
+		return 1e9 * std::chrono::steady_clock::period::num / std::chrono::steady_clock::period::den;
+#endif
+	}
+
+	void RecordProfileSample(const ProfileStage stage, const int64_t startTicks, const int64_t endTicks) {
+		const auto ns = static_cast<uint64_t>(static_cast<double>(std::max<int64_t>(0, endTicks - startTicks)) * ProfileNsPerTick);
+		StageStats& stats = ProfileStats[static_cast<size_t>(stage)];
+
+		const uint64_t index = stats.Count.fetch_add(1, std::memory_order::relaxed);
+		stats.TotalNs.fetch_add(ns, std::memory_order::relaxed);
+		stats.Buckets[std::min<int>(std::bit_width(ns), PROFILE_HISTOGRAM_BUCKETS - 1)].fetch_add(1, std::memory_order::relaxed);
+		stats.HistoryUs[index % PROFILE_HISTORY].store(static_cast<float>(ns) * 1e-3f, std::memory_order::relaxed);
+
+		for (uint64_t max = stats.MaxNs.load(std::memory_order::relaxed);
+			ns > max && !stats.MaxNs.compare_exchange_weak(max, ns, std::memory_order::relaxed);) {}
+
+		if (TraceEnabled.test(std::memory_order::relaxed)) {
+			TraceBuffer& buffer = ThreadTraceBuffer();
+			const uint64_t head = buffer.Head.load(std::memory_order::relaxed);
+			buffer.Events[head % TRACE_CAPACITY] = { startTicks, endTicks, stage };
+			buffer.Head.store(head + 1, std::memory_order::release);
+		}
+	}
+
+	TraceBuffer& ThreadTraceBuffer() {
+		thread_local TraceBuffer* buffer = nullptr;
+
+		if (!buffer) {
+			Lock lock(TraceBuffersMutex);
+			TraceBuffers.push_back(std::make_unique<TraceBuffer>());
+			buffer = TraceBuffers.back().get();
+			buffer->ThreadId = static_cast<uint32_t>(TraceBuffers.size());
+		}
+
+		return *buffer;
+	}
+
+	double ProfilePercentileUs(const ProfileStage stage, const double fraction) {
+		const StageStats& stats = ProfileStats[static_cast<size_t>(stage)];
+
+		uint64_t total = 0;
+		for (const auto& bucket : stats.Buckets) total += bucket.load(std::memory_order::relaxed);
+		if (total == 0) return 0.0;
+
+		// Report the upper edge of the bucket that contains the percentile
+		const auto target = static_cast<uint64_t>(std::ceil(static_cast<double>(total) * fraction));
+		uint64_t seen = 0;
+
+		for (int b = 0; b < PROFILE_HISTOGRAM_BUCKETS; b++) {
+			seen += stats.Buckets[b].load(std::memory_order::relaxed);
+			if (seen >= target) return std::ldexp(1.0, b) * 1e-3;
+		}
+
+		return std::ldexp(1.0, PROFILE_HISTOGRAM_BUCKETS - 1) * 1e-3;
+	}
+
+	void ResetProfiler() {
+		for (StageStats& stats : ProfileStats) {
+			stats.Count.store(0, std::memory_order::relaxed);
+			stats.TotalNs.store(0, std::memory_order::relaxed);
+			stats.MaxNs.store(0, std::memory_order::relaxed);
+			for (auto& bucket : stats.Buckets) bucket.store(0, std::memory_order::relaxed);
+			for (auto& sample : stats.HistoryUs) sample.store(0.0f, std::memory_order::relaxed);
+		}
+
+		Lock lock(TraceBuffersMutex);
+		for (const auto& buffer : TraceBuffers) buffer->Head.store(0, std::memory_order::release);
+	}
+
+	bool WriteChromeTrace(const std::string& filename) {
+		std::ofstream file(filename);
+
+		if (file.fail()) {
+			std::cerr << "Could not open trace file " << filename << "\n";
+			return false;
+		}
+
+		Lock lock(TraceBuffersMutex);
+
+		// Timestamps are made relative to the earliest recorded event
+		int64_t origin = INT64_MAX;
+		for (const auto& buffer : TraceBuffers) {
+			const uint64_t head = buffer->Head.load(std::memory_order::acquire);
+			const uint64_t first = head > TRACE_CAPACITY ? head - TRACE_CAPACITY : 0;
+			for (uint64_t e = first; e < head; e++) origin = std::min(origin, buffer->Events[e % TRACE_CAPACITY].StartTicks);
+		}
+
+		// Microseconds with nanosecond digits, the default format turns scientific and drops them past a second
+		file << std::fixed;
+		file.precision(3);
+
+		file << "{\"traceEvents\":[";
+		bool firstEvent = true;
+
+		for (const auto& buffer : TraceBuffers) {
+			// Events may be overwritten by their thread while exporting, which only affects the oldest ones
+			const uint64_t head = buffer->Head.load(std::memory_order::acquire);
+			const uint64_t first = head > TRACE_CAPACITY ? head - TRACE_CAPACITY : 0;
+
+			for (uint64_t e = first; e < head; e++) {
+				const TraceEvent& event = buffer->Events[e % TRACE_CAPACITY];
+				file << (firstEvent ? "\n" : ",\n")
+					<< "{\"name\":\"" << ProfileStageNames[static_cast<size_t>(event.Stage)] << "\",\"ph\":\"X\",\"pid\":1"
+					<< ",\"tid\":" << buffer->ThreadId
+					<< ",\"ts\":" << static_cast<double>(event.StartTicks - origin) * ProfileNsPerTick * 1e-3
+					<< ",\"dur\":" << static_cast<double>(event.EndTicks - event.StartTicks) * ProfileNsPerTick * 1e-3 << "}";
+				firstEvent = false;
+			}
+		}
+
+		file << "\n]}\n";
+		return !file.fail();
+	}
+
+	int64_t StartupElapsedNs() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - StartupClockOrigin).count();
+	}
+
+	int64_t EndStartupPhase(const char* const name, const int64_t startNs) {
+		const int64_t endNs = StartupElapsedNs();
+
+		Lock lock(StartupPhasesMutex);
+		StartupPhases.push_back({ name, startNs, endNs });
+		return endNs;
+	}
+
+	void PrintStartupTimeline() {
+		Lock lock(StartupPhasesMutex);
+
+		std::vector<StartupPhase> phases = StartupPhases;
+		std::ranges::sort(phases, {}, &StartupPhase::StartNs);
+
+		int64_t endNs = 0;
+		for (const StartupPhase& phase : phases) endNs = std::max(endNs, phase.EndNs);
+
+		std::cout << "Startup timeline, " << static_cast<double>(endNs) * 1e-6 << " ms in total\n";
+		for (const StartupPhase& phase : phases) {
+			std::cout << "  " << phase.Name << ": at " << static_cast<double>(phase.StartNs) * 1e-6 << " ms, took "
+				<< static_cast<double>(phase.EndNs - phase.StartNs) * 1e-6 << " ms\n";
+		}
+	}
+
+	void DrawProfilerWindow() {
+		ImGui::Begin("Profiler");
+
+		bool tracing = TraceEnabled.test(std::memory_order::relaxed);
+		if (ImGui::Checkbox("Record trace", &tracing)) {
+			if (tracing) TraceEnabled.test_and_set(std::memory_order::relaxed);
+			else TraceEnabled.clear(std::memory_order::relaxed);
+		}
+
+		ImGui::SameLine();
+		if (ImGui::Button("Export trace.json")) WriteChromeTrace("trace.json");
+
+		ImGui::SameLine();
+		if (ImGui::Button("Reset")) ResetProfiler();
+
+		if (ImGui::CollapsingHeader("Startup")) {
+			Lock lock(StartupPhasesMutex);
+
+			for (const StartupPhase& phase : StartupPhases) {
+				ImGui::Text("%-12s at %8.2f ms, took %8.2f ms", phase.Name, static_cast<double>(phase.StartNs) * 1e-6,
+					static_cast<double>(phase.EndNs - phase.StartNs) * 1e-6);
+			}
+		}
+
+		for (size_t s = 0; s < static_cast<size_t>(ProfileStage::Count); s++) {
+			const StageStats& stats = ProfileStats[s];
+			const uint64_t count = stats.Count.load(std::memory_order::relaxed);
+			if (count == 0) continue;
+
+			const auto stage = static_cast<ProfileStage>(s);
+			const double averageUs = static_cast<double>(stats.TotalNs.load(std::memory_order::relaxed)) * 1e-3 / static_cast<double>(count);
+
+			if (!ImGui::CollapsingHeader(ProfileStageNames[s])) {
+				ImGui::SameLine(160);
+				ImGui::Text("avg %.1f us", averageUs);
+				continue;
+			}
+
+			ImGui::Text("%llu samples, avg %.1f us, p50 < %.1f us, p99 < %.1f us, max %.1f us",
+				static_cast<unsigned long long>(count), averageUs,
+				ProfilePercentileUs(stage, 0.5), ProfilePercentileUs(stage, 0.99),
+				static_cast<double>(stats.MaxNs.load(std::memory_order::relaxed)) * 1e-3);
+
+			// Oldest sample first so the timeline scrolls left
+			float history[PROFILE_HISTORY];
+			for (int i = 0; i < PROFILE_HISTORY; i++) {
+				history[i] = stats.HistoryUs[(count + i) % PROFILE_HISTORY].load(std::memory_order::relaxed);
+			}
+
+			float buckets[PROFILE_HISTOGRAM_BUCKETS];
+			for (int b = 0; b < PROFILE_HISTOGRAM_BUCKETS; b++) {
+				buckets[b] = static_cast<float>(stats.Buckets[b].load(std::memory_order::relaxed));
+			}
+
+			ImGui::PushID(static_cast<int>(s));
+			ImGui::PlotLines("us", history, PROFILE_HISTORY, 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 60));
+			ImGui::PlotHistogram("log2 ns", buckets, PROFILE_HISTOGRAM_BUCKETS, 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 60));
+			ImGui::PopID();
+		}
+
+		ImGui::End();
+	}
+}
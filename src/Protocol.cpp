@@ -0,0 +1,166 @@
+#include <pch.h>
+#include <NetworkingPhysics.h>
+#include <Protocol.h>
+
+namespace NetPhysics {
+	size_t BeginPacket(ByteWriter& writer, const MessageType type) {
+		const size_t start = writer.Offset;
+		WriteField(writer, PacketHeader { PROTOCOL_MAGIC, PROTOCOL_VERSION, type, 0, 0 });
+		return start;
+	}
+
+	void EndPacket(ByteWriter& writer, const size_t start) {
+		if (writer.Overflow) return;
+
+		// Patch the payload size now that it is known
+		ByteWriter size { writer.Buffer.subspan(start + PACKET_HEADER_SIZE - sizeof(uint32_t), sizeof(uint32_t)) };
+		WriteField(size, static_cast<uint32_t>(writer.Offset - start - PACKET_HEADER_SIZE));
+	}
+
+	size_t EncodeBodyEvents(const BodyMask& events, const BodyMask& live, const std::span<std::byte> out) {
+		ByteWriter writer { out };
+
+		ForEachBodyBit(events, [&](const int i) {
+			WriteField(writer, BodyEvent { static_cast<uint32_t>(i) | (TestBodyBit(live, i) ? 0u : BODY_EVENT_DESPAWN) });
+		});
+
+		return writer.Overflow ? 0 : writer.Offset;
+	}
+
+	size_t EncodeSnapshotBodies(const std::span<const TriangleData> bodies, const std::span<std::byte> out) {
+		ByteWriter writer { out };
+		for (const TriangleData& body : bodies) WriteField(writer, body);
+		return writer.Overflow ? 0 : writer.Offset;
+	}
+
+	size_t EncodeDeltaBodies(const std::span<const TriangleData> bodies, const BodyMask& changed, const std::span<std::byte> out) {
+		ByteWriter writer { out };
+
+		ForEachBodyBit(changed, [&](const int i) {
+			WriteField(writer, BodyDelta { static_cast<uint32_t>(i), bodies[i] });
+		});
+
+		return writer.Overflow ? 0 : writer.Offset;
+	}
+
+	size_t EncodeSnapshotPacket(const SnapshotMessage& message, const std::span<const TriangleData> bodies, const std::span<std::byte> out) {
+		ByteWriter writer { out };
+		const size_t start = BeginPacket(writer, MessageType::Snapshot);
+		WriteField(writer, message);
+
+		for (uint32_t i = 0; i < message.BodyCount && i < bodies.size(); i++) {
+			WriteField(writer, bodies[i]);
+		}
+
+		EndPacket(writer, start);
+		return writer.Overflow ? 0 : writer.Offset;
+	}
+
+	size_t EncodeDeltaPacket(DeltaMessage message, const std::span<const TriangleData> bodies, const BodyMask& changed, const std::span<std::byte> out) {
+		message.EventCount = 0;
+		message.ChangedCount = 0;
+		for (const uint64_t word : changed) message.ChangedCount += std::popcount(word);
+
+		ByteWriter writer { out };
+		const size_t start = BeginPacket(writer, MessageType::Delta);
+		WriteField(writer, message);
+
+		ForEachBodyBit(changed, [&](const int i) {
+			WriteField(writer, BodyDelta { static_cast<uint32_t>(i), bodies[i] });
+		});
+
+		EndPacket(writer, start);
+		return writer.Overflow ? 0 : writer.Offset;
+	}
+
+	bool ReadPacketHeader(const std::span<const std::byte> data, PacketHeader& header) {
+		ByteReader reader { data };
+		ReadField(reader, header);
+
+		return !reader.Overflow && header.Magic == PROTOCOL_MAGIC && header.Version == PROTOCOL_VERSION
+			&& header.Type < MessageType::Count && header.Size <= MAX_PACKET_PAYLOAD;
+	}
+
+	uint16_t SnapshotChunkCount(const size_t size) {
+		return static_cast<uint16_t>(std::max<size_t>(1, (size + SNAPSHOT_CHUNK_BYTES - 1) / SNAPSHOT_CHUNK_BYTES));
+	}
+
+	bool AddSnapshotChunk(SnapshotAssembly& assembly, const PacketHeader& header, const uint32_t sequence, const uint16_t chunkIndex,
+		const uint16_t chunkCount, const ByteReader& reader) {
+		if (chunkCount == 0 || chunkIndex >= chunkCount || static_cast<size_t>(chunkCount) * SNAPSHOT_CHUNK_BYTES
+			> MAX_SNAPSHOT_PAYLOAD + SNAPSHOT_CHUNK_BYTES) return false;
+
+		if (assembly.Received.empty() || sequence != assembly.Sequence) {
+			if (!assembly.Received.empty() && static_cast<int32_t>(sequence - assembly.Sequence) < 0) return false;
+
+			assembly.Sequence = sequence;
+			assembly.Type = header.Type;
+			assembly.Flags = header.Flags;
+			assembly.Payload.resize(static_cast<size_t>(chunkCount) * SNAPSHOT_CHUNK_BYTES);
+			assembly.Received.assign(chunkCount, false);
+			assembly.Remaining = chunkCount;
+		}
+
+		if (header.Type != assembly.Type || header.Flags != assembly.Flags || chunkCount != assembly.Received.size()) return false;
+
+		// Every chunk but the last is full, so the last one's size fixes the payload size
+		const auto bytes = reader.Buffer.subspan(reader.Offset);
+		const bool last = chunkIndex + 1 == chunkCount;
+		if (bytes.size() > SNAPSHOT_CHUNK_BYTES || (!last && bytes.size() != SNAPSHOT_CHUNK_BYTES)) return false;
+
+		if (assembly.Received[chunkIndex]) return true;
+
+		std::ranges::copy(bytes, assembly.Payload.begin() + static_cast<ptrdiff_t>(chunkIndex * SNAPSHOT_CHUNK_BYTES));
+		if (last) assembly.Payload.resize(chunkIndex * SNAPSHOT_CHUNK_BYTES + bytes.size());
+
+		assembly.Received[chunkIndex] = true;
+		assembly.Remaining--;
+		return true;
+	}
+
+	bool SnapshotComplete(const SnapshotAssembly& assembly) {
+		return !assembly.Received.empty() && assembly.Remaining == 0;
+	}
+
+	ByteReader PacketPayload(const std::span<const std::byte> packet) {
+		return ByteReader { packet.subspan(PACKET_HEADER_SIZE) };
+	}
+
+	bool DecodeBodyEvents(ByteReader& reader, const uint32_t count, BodyMask& live) {
+		for (uint32_t i = 0; i < count; i++) {
+			BodyEvent event;
+			ReadField(reader, event);
+
+			const uint32_t index = event.Index & ~BODY_EVENT_DESPAWN;
+			if (reader.Overflow || index >= COUNT_TRIANGLES) return false;
+
+			if ((event.Index & BODY_EVENT_DESPAWN) != 0)
+				ClearBodyBit(live, static_cast<int>(index));
+			else
+				SetBodyBit(live, static_cast<int>(index));
+		}
+
+		return true;
+	}
+
+	bool DecodeSnapshotBodies(ByteReader& reader, const SnapshotMessage& message, const std::span<TriangleData> bodies) {
+		if (message.BodyCount != bodies.size()) return false;
+
+		for (TriangleData& body : bodies) ReadField(reader, body);
+		return !reader.Overflow;
+	}
+
+	bool DecodeDeltaBodies(ByteReader& reader, const DeltaMessage& message, const std::span<TriangleData> bodies) {
+		if (message.BodyCount != bodies.size()) return false;
+
+		for (uint32_t i = 0; i < message.ChangedCount; i++) {
+			BodyDelta delta;
+			ReadField(reader, delta);
+
+			if (reader.Overflow || delta.Index >= bodies.size()) return false;
+			bodies[delta.Index] = delta.State;
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
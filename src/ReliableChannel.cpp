@@ -0,0 +1,105 @@
+#include <pch.h>
+#include <NetworkingPhysics.h>
+#include <Protocol.h>
+#include <ReliableChannel.h>
+
+namespace NetPhysics {
+	bool ChannelIdle(const ReliableChannel& channel) {
+		return channel.Queued.empty() && channel.OldestUnacked == channel.NextSequence;
+	}
+
+	void ChannelQueue(ReliableChannel& channel, const std::span<const std::byte> packet) {
+		channel.Queued.emplace_back(packet.begin(), packet.end());
+	}
+
+	ChannelAck ChannelMakeAck(const ReliableChannel& channel) {
+		ChannelAck ack { channel.NextExpected, 0 };
+
+		for (uint16_t i = 0; i + 1 < RELIABLE_WINDOW; i++) {
+			const uint16_t sequence = channel.NextExpected + 1 + i;
+			if (channel.Received[sequence % RELIABLE_WINDOW].Filled) ack.Bits |= 1u << i;
+		}
+
+		return ack;
+	}
+
+	void ChannelProcessAck(ReliableChannel& channel, const ChannelAck& ack) {
+		const uint16_t inFlight = channel.NextSequence - channel.OldestUnacked;
+
+		// An ack for sequences never sent is stale or corrupt
+		if (static_cast<uint16_t>(ack.Next - channel.OldestUnacked) > inFlight
+			&& static_cast<int16_t>(ack.Next - channel.OldestUnacked) >= 0) return;
+
+		for (uint16_t sequence = channel.OldestUnacked; sequence != channel.NextSequence; sequence++) {
+			const uint16_t beyond = sequence - ack.Next - 1;
+			const bool acked = static_cast<int16_t>(sequence - ack.Next) < 0
+				|| (beyond < 32 && (ack.Bits >> beyond & 1u) != 0);
+
+			if (acked) channel.Sent[sequence % RELIABLE_WINDOW].Pending = false;
+		}
+
+		while (channel.OldestUnacked != channel.NextSequence && !channel.Sent[channel.OldestUnacked % RELIABLE_WINDOW].Pending) {
+			channel.Sent[channel.OldestUnacked % RELIABLE_WINDOW].Packet.clear();
+			channel.OldestUnacked++;
+		}
+	}
+
+	void ChannelFlush(ReliableChannel& channel, const int64_t nowNs, const std::function<void(std::span<const std::byte>)>& send) {
+		while (!channel.Queued.empty() && static_cast<uint16_t>(channel.NextSequence - channel.OldestUnacked) < RELIABLE_WINDOW) {
+			ReliableSlot& slot = channel.Sent[channel.NextSequence % RELIABLE_WINDOW];
+			slot.Packet = std::move(channel.Queued.front());
+			slot.LastSendNs = 0;
+			slot.Pending = true;
+
+			channel.Queued.pop_front();
+			channel.NextSequence++;
+		}
+
+		const ChannelAck ack = ChannelMakeAck(channel);
+		std::array<std::byte, PACKET_HEADER_SIZE + WireSize<ReliableMessage>() + MAX_RELIABLE_PAYLOAD> packet;
+
+		for (uint16_t sequence = channel.OldestUnacked; sequence != channel.NextSequence; sequence++) {
+			ReliableSlot& slot = channel.Sent[sequence % RELIABLE_WINDOW];
+			if (!slot.Pending || (slot.LastSendNs != 0 && nowNs - slot.LastSendNs < RELIABLE_RESEND_NS)) continue;
+
+			// The ack is refreshed on every send, so resends also carry the latest receive state
+			const size_t prefix = EncodePacketPrefix(ReliableMessage { sequence, ack }, slot.Packet.size(), packet);
+			if (prefix == 0 || prefix + slot.Packet.size() > packet.size()) continue;
+
+			std::ranges::copy(slot.Packet, packet.begin() + prefix);
+			send(std::span(packet).first(prefix + slot.Packet.size()));
+
+			if (slot.LastSendNs != 0) channel.Resends++;
+			slot.LastSendNs = nowNs;
+		}
+	}
+
+	bool ChannelReceive(ReliableChannel& channel, ByteReader& reader, const std::function<void(std::span<const std::byte>)>& deliver) {
+		ReliableMessage message;
+		if (!DecodeMessage(reader, message)) return false;
+
+		ChannelProcessAck(channel, message.Channel);
+
+		const auto packet = reader.Buffer.subspan(reader.Offset);
+		if (packet.size() < PACKET_HEADER_SIZE || packet.size() > MAX_RELIABLE_PAYLOAD) return false;
+
+		// Duplicates of delivered messages and anything beyond the window are dropped, the ack covers them
+		const uint16_t ahead = message.Sequence - channel.NextExpected;
+		if (ahead >= RELIABLE_WINDOW) return true;
+
+		ReliableReceiveSlot& slot = channel.Received[message.Sequence % RELIABLE_WINDOW];
+		if (!slot.Filled) {
+			slot.Packet.assign(packet.begin(), packet.end());
+			slot.Filled = true;
+		}
+
+		for (ReliableReceiveSlot* next = &channel.Received[channel.NextExpected % RELIABLE_WINDOW]; next->Filled;
+			next = &channel.Received[channel.NextExpected % RELIABLE_WINDOW]) {
+			next->Filled = false;
+			channel.NextExpected++;
+			deliver(next->Packet);
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
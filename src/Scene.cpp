@@ -0,0 +1,405 @@
+#include <pch.h>
+#include <NetworkingPhysics.h>
+#include <Scene.h>
+#include <BodyPool.h>
+
+namespace NetPhysics {
+	uint64_t HashSceneBytes(const std::span<const std::byte> bytes) {
+		uint64_t hash = 0xCBF29CE484222325;
+		for (const std::byte b : bytes) {
+			hash ^= std::to_integer<uint64_t>(b);
+			hash *= 0x100000001B3;
+		}
+		return hash;
+	}
+
+	SceneShape BoxShape(const float halfWidth, const float halfHeight) {
+		return SceneShape { 4, { { -halfWidth, -halfHeight }, { halfWidth, -halfHeight }, { halfWidth, halfHeight }, { -halfWidth, halfHeight } } };
+	}
+
+	bool ParseSceneText(const std::string& filename, SceneDescription& scene) {
+		std::ifstream in(filename);
+		if (!in) {
+			std::cerr << "Failed to read scene " << filename << "\n";
+			return false;
+		}
+
+		std::unordered_map<std::string, uint32_t> shapes;
+		std::unordered_map<std::string, uint32_t> materials;
+		int lineNumber = 0;
+
+		const auto fail = [&](const char* message) {
+			std::cerr << filename << ":" << lineNumber << ": " << message << "\n";
+			return false;
+		};
+
+		const auto lookup = [](const std::unordered_map<std::string, uint32_t>& names, const std::string& name, uint32_t& index) {
+			const auto found = names.find(name);
+			if (found == names.end()) return false;
+			index = found->second;
+			return true;
+		};
+
+		for (std::string line; std::getline(in, line);) {
+			lineNumber++;
+
+			std::istringstream tokens(line.substr(0, line.find('#')));
+			std::string directive;
+			if (!(tokens >> directive)) continue;
+
+			if (directive == "shape") {
+				std::string name, kind;
+				if (!(tokens >> name >> kind)) return fail("expected shape NAME box|polygon ...");
+
+				std::vector<float> values;
+				for (float value; tokens >> value;) values.push_back(value);
+				if (!tokens.eof()) return fail("expected a number");
+
+				SceneShape shape {};
+				if (kind == "box") {
+					if (values.size() != 2 || !(values[0] > 0 && values[1] > 0)) return fail("a box needs a positive half width and half height");
+					shape = BoxShape(values[0], values[1]);
+				}
+				else if (kind == "polygon") {
+					if (values.size() % 2 != 0 || values.size() < 6 || values.size() > 2 * SCENE_MAX_VERTICES)
+						return fail("a polygon needs 3 to 8 vertices");
+
+					shape.VertexCount = static_cast<uint32_t>(values.size() / 2);
+					std::memcpy(shape.Vertices, values.data(), values.size() * sizeof(float));
+				}
+				else
+					return fail("unknown shape kind, expected box or polygon");
+
+				if (!shapes.emplace(name, static_cast<uint32_t>(scene.Shapes.size())).second) return fail("shape already defined");
+				scene.Shapes.push_back(shape);
+				continue;
+			}
+
+			if (directive == "material") {
+				std::string name;
+				SceneMaterial material;
+				if (!(tokens >> name >> material.Density >> material.Friction >> material.Restitution))
+					return fail("expected material NAME DENSITY FRICTION RESTITUTION");
+
+				if (!materials.emplace(name, static_cast<uint32_t>(scene.Materials.size())).second) return fail("material already defined");
+				scene.Materials.push_back(material);
+			}
+			else if (directive == "static") {
+				std::string shape, material;
+				SceneStatic item;
+				if (!(tokens >> shape >> material >> item.X >> item.Y >> item.Angle)) return fail("expected static SHAPE MATERIAL X Y ANGLE");
+				if (!lookup(shapes, shape, item.Shape)) return fail("unknown shape");
+				if (!lookup(materials, material, item.Material)) return fail("unknown material");
+
+				scene.Statics.push_back(item);
+			}
+			else if (directive == "body") {
+				std::string material;
+				SceneBody body;
+				auto& [SpatialData, PhysicsData] = body.State;
+				if (!(tokens >> material >> SpatialData[0] >> SpatialData[1] >> SpatialData[2] >> PhysicsData[0] >> PhysicsData[1] >> PhysicsData[2]))
+					return fail("expected body MATERIAL X Y ANGLE VX VY ANGULAR_VELOCITY");
+				if (!lookup(materials, material, body.Material)) return fail("unknown material");
+
+				scene.Bodies.push_back(body);
+			}
+			else if (directive == "grid") {
+				std::string material;
+				int count, columns;
+				float x, y, spacing, vx, vy;
+				if (!(tokens >> material >> count >> columns >> x >> y >> spacing >> vx >> vy))
+					return fail("expected grid MATERIAL COUNT COLUMNS X Y SPACING VX VY");
+				if (count <= 0 || columns <= 0) return fail("a grid needs a positive count and column count");
+
+				uint32_t index;
+				if (!lookup(materials, material, index)) return fail("unknown material");
+
+				for (int i = 0; i < count; i++) {
+					const float cellX = x + static_cast<float>(i % columns) * spacing;
+					const float cellY = y + static_cast<float>(i / columns) * spacing;
+					scene.Bodies.push_back(SceneBody { index, { { cellX, cellY, 0 }, { vx, vy, 0 } } });
+				}
+			}
+			else
+				return fail("unknown directive");
+
+			if (!(tokens >> std::ws).eof()) return fail("unexpected values at the end of the line");
+		}
+
+		return true;
+	}
+
+	std::vector<std::byte> CompileScene(const SceneDescription& scene) {
+		const SceneHeader header { SCENE_MAGIC, SCENE_VERSION, static_cast<uint32_t>(scene.Shapes.size()),
+			static_cast<uint32_t>(scene.Materials.size()), static_cast<uint32_t>(scene.Statics.size()), static_cast<uint32_t>(scene.Bodies.size()) };
+
+		std::vector<std::byte> bytes(sizeof(SceneHeader) + scene.Shapes.size() * sizeof(SceneShape) + scene.Materials.size() * sizeof(SceneMaterial)
+			+ scene.Statics.size() * sizeof(SceneStatic) + scene.Bodies.size() * sizeof(SceneBody));
+		size_t offset = 0;
+
+		const auto append = [&](const void* data, const size_t size) {
+			if (size > 0) std::memcpy(bytes.data() + offset, data, size);
+			offset += size;
+		};
+
+		append(&header, sizeof(header));
+		append(scene.Shapes.data(), scene.Shapes.size() * sizeof(SceneShape));
+		append(scene.Materials.data(), scene.Materials.size() * sizeof(SceneMaterial));
+		append(scene.Statics.data(), scene.Statics.size() * sizeof(SceneStatic));
+		append(scene.Bodies.data(), scene.Bodies.size() * sizeof(SceneBody));
+		return bytes;
+	}
+
+	bool ViewScene(const std::span<const std::byte> bytes, Scene& scene) {
+		SceneHeader header;
+		if (bytes.size() < sizeof(header)) return false;
+		std::memcpy(&header, bytes.data(), sizeof(header));
+
+		if (header.Magic != SCENE_MAGIC || header.Version != SCENE_VERSION) {
+			std::cerr << "Not a compiled scene of version " << SCENE_VERSION << "\n";
+			return false;
+		}
+
+		const uint64_t expected = sizeof(SceneHeader) + uint64_t { header.ShapeCount } * sizeof(SceneShape)
+			+ uint64_t { header.MaterialCount } * sizeof(SceneMaterial) + uint64_t { header.StaticCount } * sizeof(SceneStatic)
+			+ uint64_t { header.BodyCount } * sizeof(SceneBody);
+
+		if (bytes.size() != expected || reinterpret_cast<uintptr_t>(bytes.data()) % alignof(SceneHeader) != 0) {
+			std::cerr << "Scene is truncated or misaligned\n";
+			return false;
+		}
+
+		if (header.BodyCount > COUNT_TRIANGLES) {
+			std::cerr << "Scene holds " << header.BodyCount << " bodies, this build simulates " << COUNT_TRIANGLES << "\n";
+			return false;
+		}
+
+		// The tables are used in place, straight from the mapped file
+		size_t offset = sizeof(SceneHeader);
+		const auto table = [&]<typename T>(std::span<const T>& out, const uint32_t count) {
+			out = std::span(reinterpret_cast<const T*>(bytes.data() + offset), count);
+			offset += count * sizeof(T);
+		};
+
+		table(scene.Shapes, header.ShapeCount);
+		table(scene.Materials, header.MaterialCount);
+		table(scene.Statics, header.StaticCount);
+		table(scene.Bodies, header.BodyCount);
+
+		for (const SceneShape& shape : scene.Shapes) {
+			if (shape.VertexCount < 3 || shape.VertexCount > SCENE_MAX_VERTICES) {
+				std::cerr << "Scene shape with " << shape.VertexCount << " vertices\n";
+				return false;
+			}
+
+			// Box2D asserts on polygons that collapse to less than a triangle
+			float area = 0;
+			for (uint32_t i = 0; i < shape.VertexCount; i++) {
+				const float* a = shape.Vertices[i];
+				const float* b = shape.Vertices[(i + 1) % shape.VertexCount];
+				area += a[0] * b[1] - b[0] * a[1];
+			}
+
+			if (!(std::abs(area) > 1e-4f)) {
+				std::cerr << "Scene shape has no area\n";
+				return false;
+			}
+		}
+
+		for (const SceneStatic& item : scene.Statics) {
+			if (item.Shape >= header.ShapeCount || item.Material >= header.MaterialCount) {
+				std::cerr << "Scene static body refers to a missing shape or material\n";
+				return false;
+			}
+		}
+
+		for (const SceneBody& body : scene.Bodies) {
+			const auto& [SpatialData, PhysicsData] = body.State;
+			const bool finite = std::isfinite(SpatialData[0]) && std::isfinite(SpatialData[1]) && std::isfinite(SpatialData[2])
+				&& std::isfinite(PhysicsData[0]) && std::isfinite(PhysicsData[1]) && std::isfinite(PhysicsData[2]);
+
+			if (body.Material >= header.MaterialCount || !finite) {
+				std::cerr << "Scene body with a missing material or a non-finite state\n";
+				return false;
+			}
+		}
+
+		scene.Hash = HashSceneBytes(bytes);
+		scene.Bytes = bytes.size();
+		return true;
+	}
+
+	bool LoadScene(const std::string& filename, Scene& scene) {
+		const auto start = std::chrono::steady_clock::now();
+
+		if (std::filesystem::path(filename).extension() != ".bin") {
+			SceneDescription description;
+			if (!ParseSceneText(filename, description)) return false;
+
+			scene.Compiled = CompileScene(description);
+			if (!ViewScene(scene.Compiled, scene)) {
+				UnloadScene(scene);
+				return false;
+			}
+		}
+		else {
+			const HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+				FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+			if (file == INVALID_HANDLE_VALUE) {
+				std::cerr << "Failed to open scene " << filename << "\n";
+				return false;
+			}
+
+			LARGE_INTEGER size {};
+			GetFileSizeEx(file, &size);
+
+			// The mapping keeps the file open on its own
+			scene.Mapping = size.QuadPart > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+			CloseHandle(file);
+
+			if (scene.Mapping != nullptr) scene.View = MapViewOfFile(scene.Mapping, FILE_MAP_READ, 0, 0, 0);
+
+			if (scene.View == nullptr
+				|| !ViewScene(std::span(static_cast<const std::byte*>(scene.View), static_cast<size_t>(size.QuadPart)), scene)) {
+				std::cerr << "Failed to map scene " << filename << "\n";
+				UnloadScene(scene);
+				return false;
+			}
+		}
+
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::cout << "Loaded scene " << filename << " (" << std::hex << scene.Hash << std::dec << "), "
+			<< scene.Bodies.size() << " bodies in " << ms << " ms\n";
+		return true;
+	}
+
+	b2Vec2 GridCell(const int index) {
+		constexpr int half = BODY_GRID_COLUMNS / 2;
+		return b2Vec2(static_cast<float>(index % BODY_GRID_COLUMNS - half), static_cast<float>(index / BODY_GRID_COLUMNS - half));
+	}
+
+	void BuildDefaultScene(Scene& scene) {
+		constexpr float wallLength = std::max(20.0f, ARENA_HALF_EXTENT + 1.0f);
+
+		SceneDescription description;
+		description.Shapes = { BoxShape(wallLength, 0.5f), BoxShape(0.5f, wallLength) };
+		description.Materials = { DEFAULT_STATIC_MATERIAL, DEFAULT_BODY_MATERIAL };
+		description.Statics = {
+			{ 0, 0, 0, -ARENA_HALF_EXTENT, 0 },
+			{ 0, 0, 0, ARENA_HALF_EXTENT, 0 },
+			{ 1, 0, ARENA_HALF_EXTENT, 0, 0 },
+			{ 1, 0, -ARENA_HALF_EXTENT, 0, 0 }
+		};
+
+		// Each body starts moving away from the center, as fast as it is far from it
+		description.Bodies.resize(COUNT_TRIANGLES);
+		for (int i = 0; i < COUNT_TRIANGLES; i++) {
+			const b2Vec2 cell = GridCell(i);
+			description.Bodies[i] = SceneBody { 1, { { cell.x, cell.y, 0 }, { cell.x, cell.y, 0 } } };
+		}
+
+		scene.Compiled = CompileScene(description);
+		ViewScene(scene.Compiled, scene);
+	}
+
+	void UnloadScene(Scene& scene) {
+		if (scene.View != nullptr) UnmapViewOfFile(scene.View);
+		if (scene.Mapping != nullptr) CloseHandle(scene.Mapping);
+		scene = Scene {};
+	}
+
+	bool CompileSceneFile(const std::string& input, const std::string& output) {
+		SceneDescription description;
+		if (!ParseSceneText(input, description)) return false;
+
+		const std::vector<std::byte> bytes = CompileScene(description);
+
+		Scene scene;
+		if (!ViewScene(bytes, scene)) return false;
+
+		std::ofstream out(output, std::ios::binary);
+		out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+		if (!out) {
+			std::cerr << "Failed to write scene " << output << "\n";
+			return false;
+		}
+
+		std::cout << "Compiled scene " << output << " (" << std::hex << scene.Hash << std::dec << "), "
+			<< scene.Bodies.size() << " bodies, " << bytes.size() << " bytes\n";
+		return true;
+	}
+
+	const b2PolygonShape& TriangleShape() {
+		// Every triangle has the same shape, its hull and normals are computed once. Box2D still
+		// copies the shape into each fixture.
+		static const b2PolygonShape shape = [] {
+			const b2Vec2 triangle[3] {
+				{ TriangleVertices[0].Position[0], TriangleVertices[0].Position[1] },
+				{ TriangleVertices[1].Position[0], TriangleVertices[1].Position[1] },
+				{ TriangleVertices[2].Position[0], TriangleVertices[2].Position[1] }
+			};
+
+			b2PolygonShape triangleShape;
+			triangleShape.Set(triangle, 3);
+			return triangleShape;
+		}();
+
+		return shape;
+	}
+
+	b2Body* CreateTriangleBody(b2World& world, const b2BodyDef& bodyDef, const SceneMaterial& material) {
+		const b2PolygonShape& triangleShape = TriangleShape();
+
+		//  Define fixture
+		b2FixtureDef fixtureDef;
+		fixtureDef.shape = &triangleShape;
+		fixtureDef.density = material.Density;
+		fixtureDef.friction = material.Friction;
+		fixtureDef.restitution = material.Restitution;
+
+		b2Body* body = world.CreateBody(&bodyDef);
+		body->CreateFixture(&fixtureDef);
+		return body;
+	}
+
+	int SceneInitialState(const Scene& scene, int liveCount, const std::span<TriangleData> bodies, BodyMask& live) {
+		liveCount = std::clamp(liveCount, 0, static_cast<int>(std::min<size_t>(scene.Bodies.size(), COUNT_TRIANGLES)));
+		live.fill(0);
+
+		for (int i = 0; i < COUNT_TRIANGLES; i++) {
+			bodies[i] = i < liveCount ? scene.Bodies[i].State : ParkedBody();
+			if (i < liveCount) SetBodyBit(live, i);
+		}
+
+		return liveCount;
+	}
+
+	void CreateSceneStatics(b2World& world, std::vector<b2Body*>& statics) {
+		for (const SceneStatic& item : ActiveScene.Statics) {
+			const SceneShape& source = ActiveScene.Shapes[item.Shape];
+			const SceneMaterial& material = ActiveScene.Materials[item.Material];
+
+			b2Vec2 vertices[SCENE_MAX_VERTICES];
+			for (uint32_t i = 0; i < source.VertexCount; i++) vertices[i].Set(source.Vertices[i][0], source.Vertices[i][1]);
+
+			b2PolygonShape shape;
+			shape.Set(vertices, static_cast<int32_t>(source.VertexCount));
+
+			b2FixtureDef fixtureDef;
+			fixtureDef.shape = &shape;
+			fixtureDef.density = material.Density;
+			fixtureDef.friction = material.Friction;
+			fixtureDef.restitution = material.Restitution;
+
+			b2BodyDef bodyDef;
+			bodyDef.position.Set(item.X, item.Y);
+			bodyDef.angle = item.Angle;
+
+			b2Body* body = world.CreateBody(&bodyDef);
+			body->CreateFixture(&fixtureDef);
+			statics.push_back(body);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,231 @@
+#include <pch.h>
+#include <ShaderCache.h>
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+namespace NetPhysics {
+
+	// Program binaries are GL 4.1, the entry points are loaded by hand like glBufferStorage
+	using GetProgramBinaryFunc = void (GLAD_API_PTR*)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+	using ProgramBinaryFunc = void (GLAD_API_PTR*)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+	using ProgramParameteriFunc = void (GLAD_API_PTR*)(GLuint program, GLenum pname, GLint value);
+
+	struct ProgramBinaryFuncs {
+		GetProgramBinaryFunc GetProgramBinary = nullptr;
+		ProgramBinaryFunc ProgramBinary = nullptr;
+		ProgramParameteriFunc ProgramParameteri = nullptr;
+	};
+
+	// Empty when the context cannot hand out program binaries, some drivers expose the extension with no formats
+	ProgramBinaryFuncs LoadProgramBinaryFuncs() {
+		if (!glfwExtensionSupported("GL_ARB_get_program_binary")) return {};
+
+		GLint formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		if (formats <= 0) return {};
+
+		const ProgramBinaryFuncs funcs {
+			reinterpret_cast<GetProgramBinaryFunc>(glfwGetProcAddress("glGetProgramBinary")),
+			reinterpret_cast<ProgramBinaryFunc>(glfwGetProcAddress("glProgramBinary")),
+			reinterpret_cast<ProgramParameteriFunc>(glfwGetProcAddress("glProgramParameteri"))
+		};
+
+		return funcs.GetProgramBinary && funcs.ProgramBinary && funcs.ProgramParameteri ? funcs : ProgramBinaryFuncs {};
+	}
+
+	uint64_t HashShaderText(const std::string_view text, uint64_t hash) {
+		for (const char c : text) {
+			hash ^= static_cast<uint8_t>(c);
+			hash *= 0x100000001B3;
+		}
+		return hash;
+	}
+
+	uint64_t DriverHash() {
+		uint64_t hash = HashShaderText(std::to_string(SHADER_CACHE_VERSION));
+
+		for (const GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+			const auto text = reinterpret_cast<const char*>(glGetString(name));
+			hash = HashShaderText(text != nullptr ? text : "", hash);
+		}
+
+		return hash;
+	}
+
+	GLuint CompileShaderStage(const GLenum type, const std::string& source, const std::string& filename) {
+		const char* text = source.c_str();
+
+		const GLuint shader = glCreateShader(type);
+		glShaderSource(shader, 1, &text, nullptr);
+		glCompileShader(shader);
+
+		GLint compiled = GL_FALSE;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+		if (compiled == GL_TRUE) return shader;
+
+		GLint logLength = 0;
+		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
+		std::string log(std::max(logLength, 1), '\0');
+		glGetShaderInfoLog(shader, logLength, nullptr, log.data());
+
+		std::cerr << "Failed to compile " << filename << ":\n" << log.c_str() << "\n";
+		glDeleteShader(shader);
+		return 0;
+	}
+
+	bool LinkShaderProgram(const GLuint program, const std::string& name) {
+		glLinkProgram(program);
+
+		GLint linked = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		if (linked == GL_TRUE) return true;
+
+		GLint logLength = 0;
+		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
+		std::string log(std::max(logLength, 1), '\0');
+		glGetProgramInfoLog(program, logLength, nullptr, log.data());
+
+		std::cerr << "Failed to link shader program " << name << ":\n" << log.c_str() << "\n";
+		return false;
+	}
+
+	GLuint LoadCachedProgram(const std::filesystem::path& cacheFile, const uint64_t sourceHash, const uint64_t driverHash) {
+		const ProgramBinaryFuncs funcs = LoadProgramBinaryFuncs();
+		if (!funcs.ProgramBinary) return 0;
+
+		std::ifstream file(cacheFile, std::ios::binary);
+		if (!file) return 0;
+
+		ShaderCacheHeader header {};
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+		std::error_code error;
+		const uintmax_t fileSize = std::filesystem::file_size(cacheFile, error);
+
+		const bool valid = file && !error && header.Magic == SHADER_CACHE_MAGIC && header.Version == SHADER_CACHE_VERSION
+			&& header.SourceHash == sourceHash && header.DriverHash == driverHash && fileSize == sizeof(header) + header.Length;
+
+		std::vector<char> binary(valid ? header.Length : 0);
+		if (valid) file.read(binary.data(), static_cast<std::streamsize>(binary.size()));
+
+		GLuint program = 0;
+		if (valid && file) {
+			program = glCreateProgram();
+			funcs.ProgramBinary(program, header.Format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+			// The driver may still refuse a binary that matches, such as after a silent driver change
+			GLint linked = GL_FALSE;
+			glGetProgramiv(program, GL_LINK_STATUS, &linked);
+
+			if (linked != GL_TRUE) {
+				glDeleteProgram(program);
+				program = 0;
+			}
+		}
+
+		if (program == 0) {
+			file.close();
+			std::filesystem::remove(cacheFile, error);
+		}
+
+		return program;
+	}
+
+	void StoreProgramBinary(const GLuint program, const std::filesystem::path& cacheFile, const uint64_t sourceHash, const uint64_t driverHash) {
+		const ProgramBinaryFuncs funcs = LoadProgramBinaryFuncs();
+		if (!funcs.GetProgramBinary) return;
+
+		GLint length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0) return;
+
+		ShaderCacheHeader header { SHADER_CACHE_MAGIC, SHADER_CACHE_VERSION, sourceHash, driverHash, 0, 0 };
+		std::vector<char> binary(length);
+
+		GLsizei written = 0;
+		GLenum format = 0;
+		funcs.GetProgramBinary(program, length, &written, &format, binary.data());
+		if (written <= 0) return;
+
+		header.Format = format;
+		header.Length = static_cast<uint32_t>(written);
+
+		std::error_code error;
+		std::filesystem::create_directories(cacheFile.parent_path(), error);
+
+		std::filesystem::path temporary = cacheFile;
+		temporary += ".tmp";
+
+		{
+			std::ofstream file(temporary, std::ios::binary);
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(binary.data(), written);
+
+			if (!file) {
+				std::cerr << "Failed to write shader cache " << temporary.string() << "\n";
+				return;
+			}
+		}
+
+		std::filesystem::rename(temporary, cacheFile, error);
+		if (error) std::filesystem::remove(temporary, error);
+	}
+
+	GLuint BuildShaderProgram(const std::string& name, const std::string& vertexSource, const std::string& fragmentSource) {
+		const uint64_t sourceHash = HashShaderText(fragmentSource, HashShaderText(vertexSource, HashShaderText(name)));
+		const uint64_t driverHash = DriverHash();
+		const std::filesystem::path cacheFile = std::filesystem::path(SHADER_CACHE_DIRECTORY) / (name + ".bin");
+
+		if (ShaderCacheEnabled) {
+			if (const GLuint program = LoadCachedProgram(cacheFile, sourceHash, driverHash); program != 0) {
+				ShaderProgramCached = true;
+				return program;
+			}
+		}
+
+		ShaderProgramCached = false;
+
+		const GLuint vertexShader = CompileShaderStage(GL_VERTEX_SHADER, vertexSource, name + " vertex shader");
+		const GLuint fragmentShader = CompileShaderStage(GL_FRAGMENT_SHADER, fragmentSource, name + " fragment shader");
+
+		if (vertexShader == 0 || fragmentShader == 0) {
+			glDeleteShader(vertexShader);
+			glDeleteShader(fragmentShader);
+			return 0;
+		}
+
+		const GLuint program = glCreateProgram();
+		glAttachShader(program, vertexShader);
+		glAttachShader(program, fragmentShader);
+
+		// Must be set before linking for the driver to keep a binary around
+		const ProgramBinaryFuncs funcs = ShaderCacheEnabled ? LoadProgramBinaryFuncs() : ProgramBinaryFuncs {};
+		if (funcs.ProgramParameteri) funcs.ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+		const bool linked = LinkShaderProgram(program, name);
+
+		// The linked program keeps its own copy of the stages
+		glDetachShader(program, vertexShader);
+		glDetachShader(program, fragmentShader);
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+
+		if (!linked) {
+			glDeleteProgram(program);
+			return 0;
+		}
+
+		if (funcs.GetProgramBinary) StoreProgramBinary(program, cacheFile, sourceHash, driverHash);
+		return program;
+	}
+}
\ No newline at end of file
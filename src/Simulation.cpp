@@ -0,0 +1,195 @@
+#include <pch.h>
+#include <NetworkingPhysics.h>
+#include <Protocol.h>
+#include <NetworkShim.h>
+#include <ReliableChannel.h>
+#include <Keyframe.h>
+#include <Compression.h>
+#include <Netcode.h>
+#include <LagCompensation.h>
+#include <DeadReckoning.h>
+#include <BodyPool.h>
+#include <JobSystem.h>
+#include <WorldShards.h>
+#include <Transforms.h>
+#include <Simulation.h>
+#include <Config.h>
+#include <Profiler.h>
+#include <Metrics.h>
+
+namespace NetPhysics {
+	double SimulationTime() {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void PublishRenderState(const double time) {
+		RenderState& state = *BackRenderState;
+		state.Time = time;
+
+		if (ExtrapolationEnabled) {
+			auto& [x, y, angle] = state.Bodies;
+			ExtrapolateInstances(SimulationTicks.load(std::memory_order::relaxed), x, y, angle);
+		}
+		else if (ThinClient) {
+			// The caller holds TriDataMutex on clients, the received poses are shown as they are
+			ParallelFor(COUNT_TRIANGLES, BODIES_PER_JOB, [&state](const int begin, const int end) {
+				for (int i = begin; i < end; i++) {
+					state.Bodies.PositionX[i] = TriData[i].SpatialData[0];
+					state.Bodies.PositionY[i] = TriData[i].SpatialData[1];
+					state.Bodies.Angle[i] = TriData[i].SpatialData[2];
+				}
+			});
+		}
+		else {
+			ParallelFor(COUNT_TRIANGLES, BODIES_PER_JOB, [&state](const int begin, const int end) {
+				for (int i = begin; i < end; i++) {
+					const auto& pos = Triangles[i]->GetPosition();
+					state.Bodies.PositionX[i] = pos.x;
+					state.Bodies.PositionY[i] = pos.y;
+					state.Bodies.Angle[i] = Triangles[i]->GetAngle();
+				}
+			});
+		}
+
+		Lock lock(RenderStateMutex);
+		PreviousRenderState = CurrentRenderState;
+		CurrentRenderState = &state;
+
+		// The render thread may still be reading the states it took last, those are not written over either
+		for (RenderState& candidate : RenderStates) {
+			if (&candidate != PreviousRenderState && &candidate != CurrentRenderState
+				&& &candidate != ReadRenderStates[0] && &candidate != ReadRenderStates[1]) {
+				BackRenderState = &candidate;
+				break;
+			}
+		}
+	}
+
+	// Control state last sent to the clients, only touched by the simulation thread
+	float SentGravityModifier = 0;
+
+	void SimulationTick(const bool isServer) {
+		PROFILE_SCOPE(Tick);
+		const auto start = std::chrono::steady_clock::now();
+		constexpr float timeStep = 1.0f / static_cast<float>(SIMULATION_TICK_RATE);
+		const uint32_t tick = SimulationTicks.load(std::memory_order::relaxed) + 1;
+
+		// Clients share the bodies with the network thread, which writes them under TriDataMutex
+		std::unique_lock<std::mutex> lock(TriDataMutex, std::defer_lock);
+		if (!isServer) lock.lock();
+
+		// Thin clients have no bodies to reset, the server's next delta carries the reset
+		if (ResetRequested.exchange(false, std::memory_order::acquire) && !ThinClient) {
+			const auto resetStart = std::chrono::steady_clock::now();
+			ResetSimulation();
+			LastResetMs.store(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - resetStart).count(),
+				std::memory_order::relaxed);
+
+			if (isServer) {
+				ClearRewindHistory();
+				ResetTriangleData();
+			}
+		}
+
+		// Bodies spawned now are stepped and captured with this tick
+		if (isServer)
+			ApplyBodyRequests();
+
+		// Pushes are resolved against the poses their senders saw and act in this tick's step
+		if (isServer)
+			ApplyPendingInteractions();
+
+		const float gravity = GravityModifier.load(std::memory_order::relaxed);
+		SetShardGravity({ 0, Config.Gravity * gravity });
+
+		// Control changes must reach every client, so they go over the reliable channel
+		if (isServer && gravity != SentGravityModifier) {
+			SentGravityModifier = gravity;
+			SendReliableToClients(GravityMessage { gravity });
+		}
+		// Extrapolating and thin clients move the bodies in PublishRenderState instead
+		if (isServer || !(ExtrapolationEnabled || ThinClient)) {
+			PROFILE_SCOPE(Step);
+			StepWorldShards(timeStep, Config.VelocityIterations, Config.PositionIterations);
+		}
+
+		if (isServer) {
+			CollectTriangleData(tick);
+			RecordRewindFrame(tick);
+		}
+		SimulationTicks.store(tick, std::memory_order::relaxed);
+
+		if (!Headless)
+			PublishRenderState(SimulationTime());
+
+		const auto elapsed = std::chrono::steady_clock::now() - start;
+		LastTickMs.store(std::chrono::duration<double, std::milli>(elapsed).count(), std::memory_order::relaxed);
+		ObserveMetric(TickDurationMetric, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+	}
+
+	void SimulationLoop(const RunningFlag& running, const bool isServer) {
+		using Clock = std::chrono::steady_clock;
+		const auto tickInterval = std::chrono::duration_cast<Clock::duration>(
+			std::chrono::duration<double>(1.0 / SIMULATION_TICK_RATE));
+
+		auto nextTick = Clock::now();
+
+		while (FlagNotSet(running)) {
+			std::this_thread::sleep_until(nextTick);
+			SimulationTick(isServer);
+			nextTick += tickInterval;
+
+			// Skip ahead rather than spiral when ticks take longer than the tick interval
+			if (const auto now = Clock::now(); now - nextTick > tickInterval * MAX_CATCH_UP_TICKS)
+				nextTick = now;
+		}
+	}
+
+	void WriteInterpolatedInstances(const double renderTime, const InstanceLayout layout, void* const instances) {
+		PROFILE_SCOPE(Transforms);
+
+		// Only the pointers are taken under the lock, the simulation thread does not write the states read here
+		const RenderState* previous;
+		const RenderState* current;
+		{
+			Lock lock(RenderStateMutex);
+			previous = ReadRenderStates[0] = PreviousRenderState;
+			current = ReadRenderStates[1] = CurrentRenderState;
+		}
+
+		const InstanceArrays& from = previous->Bodies;
+		const InstanceArrays& to = current->Bodies;
+		const double span = current->Time - previous->Time;
+		const float alpha = span > 0.0
+			? static_cast<float>(std::clamp((renderTime - previous->Time) / span, 0.0, 1.0))
+			: 1.0f;
+
+		const auto lerp = [alpha](const float a, const float b) { return a + (b - a) * alpha; };
+
+		// Keyframes wrap the angle to [-pi, pi] while snapshots carry it raw, so turn along the shortest arc
+		const auto lerpAngle = [alpha](const float a, const float b) {
+			return a + std::remainder(b - a, 2.0f * std::numbers::pi_v<float>) * alpha;
+		};
+
+		ParallelFor(COUNT_TRIANGLES, BODIES_PER_JOB, [&](const int begin, const int end) {
+			if (layout == InstanceLayout::Compact) {
+				const auto poses = static_cast<vec3*>(instances);
+				for (int i = begin; i < end; i++) {
+					poses[i][0] = lerp(from.PositionX[i], to.PositionX[i]);
+					poses[i][1] = lerp(from.PositionY[i], to.PositionY[i]);
+					poses[i][2] = lerpAngle(from.Angle[i], to.Angle[i]);
+				}
+				return;
+			}
+
+			auto& [x, y, angle] = TriangleInstances;
+			for (int i = begin; i < end; i++) {
+				x[i] = lerp(from.PositionX[i], to.PositionX[i]);
+				y[i] = lerp(from.PositionY[i], to.PositionY[i]);
+				angle[i] = lerpAngle(from.Angle[i], to.Angle[i]);
+			}
+			BuildInstanceTransforms(x + begin, y + begin, angle + begin,
+				static_cast<mat4x4*>(instances) + begin, end - begin);
+		});
+	}
+}
@@ -0,0 +1,99 @@
+#include <pch.h>
+#include <NetworkingPhysics.h>
+#include <Transforms.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NETPHYSICS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace NetPhysics {
+	void BuildInstanceTransformsScalar(const float* const x, const float* const y, const float* const angle,
+		mat4x4* const out, const int count) {
+		for (int i = 0; i < count; i++) {
+			const float s = std::sin(angle[i]);
+			const float c = std::cos(angle[i]);
+
+			mat4x4& m = out[i];
+			m[0][0] = c;    m[0][1] = s;    m[0][2] = 0.0f; m[0][3] = 0.0f;
+			m[1][0] = -s;   m[1][1] = c;    m[1][2] = 0.0f; m[1][3] = 0.0f;
+			m[2][0] = 0.0f; m[2][1] = 0.0f; m[2][2] = 1.0f; m[2][3] = 0.0f;
+			m[3][0] = x[i]; m[3][1] = y[i]; m[3][2] = 0.0f; m[3][3] = 1.0f;
+		}
+	}
+
+#ifdef NETPHYSICS_SSE2
+	namespace {
+		// Selects a where mask is set and b elsewhere
+		__m128 Select(const __m128 mask, const __m128 a, const __m128 b) {
+			return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+		}
+
+		// Sine of four angles: wraps to [-pi, pi], folds to [-pi/2, pi/2] and evaluates a degree 11 polynomial
+		__m128 Sin4(__m128 a) {
+			const __m128 pi = _mm_set1_ps(3.14159265f);
+			const __m128 halfPi = _mm_set1_ps(1.57079633f);
+
+			const __m128 turns = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(a, _mm_set1_ps(0.159154943f))));
+			// Two-part 2*pi keeps the reduction exact for the large angles of long spinning bodies
+			a = _mm_sub_ps(a, _mm_mul_ps(turns, _mm_set1_ps(6.28125f)));
+			a = _mm_sub_ps(a, _mm_mul_ps(turns, _mm_set1_ps(1.93530717e-3f)));
+
+			a = Select(_mm_cmpgt_ps(a, halfPi), _mm_sub_ps(pi, a), a);
+			a = Select(_mm_cmplt_ps(a, _mm_sub_ps(_mm_setzero_ps(), halfPi)), _mm_sub_ps(_mm_sub_ps(_mm_setzero_ps(), pi), a), a);
+
+			const __m128 a2 = _mm_mul_ps(a, a);
+			__m128 p = _mm_set1_ps(-2.50521084e-8f);
+			p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(2.75573192e-6f));
+			p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(-1.98412698e-4f));
+			p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(8.33333333e-3f));
+			p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(-1.66666667e-1f));
+			p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(1.0f));
+
+			return _mm_mul_ps(p, a);
+		}
+	}
+#endif
+
+	void BuildInstanceTransforms(const float* const x, const float* const y, const float* const angle,
+		mat4x4* const out, const int count) {
+		int i = 0;
+
+#ifdef NETPHYSICS_SSE2
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 zeroOne = _mm_setr_ps(0.0f, 1.0f, 0.0f, 1.0f);
+		const __m128 column2 = _mm_setr_ps(0.0f, 0.0f, 1.0f, 0.0f);
+
+		for (; i + 4 <= count; i += 4) {
+			const __m128 a = _mm_loadu_ps(angle + i);
+			const __m128 s = Sin4(a);
+			const __m128 c = Sin4(_mm_add_ps(a, _mm_set1_ps(1.57079633f)));
+			const __m128 ns = _mm_sub_ps(zero, s);
+			const __m128 px = _mm_loadu_ps(x + i);
+			const __m128 py = _mm_loadu_ps(y + i);
+
+			// Interleave lanes into (c, s), (-s, c) and (x, y) pairs for bodies 0-1 and 2-3
+			const __m128 cs[2] = { _mm_unpacklo_ps(c, s), _mm_unpackhi_ps(c, s) };
+			const __m128 sc[2] = { _mm_unpacklo_ps(ns, c), _mm_unpackhi_ps(ns, c) };
+			const __m128 xy[2] = { _mm_unpacklo_ps(px, py), _mm_unpackhi_ps(px, py) };
+
+			for (int pair = 0; pair < 2; pair++) {
+				float* const first = &out[i + pair * 2][0][0];
+				float* const second = &out[i + pair * 2 + 1][0][0];
+
+				_mm_storeu_ps(first + 0, _mm_movelh_ps(cs[pair], zero));
+				_mm_storeu_ps(first + 4, _mm_movelh_ps(sc[pair], zero));
+				_mm_storeu_ps(first + 8, column2);
+				_mm_storeu_ps(first + 12, _mm_movelh_ps(xy[pair], zeroOne));
+
+				_mm_storeu_ps(second + 0, _mm_movehl_ps(zero, cs[pair]));
+				_mm_storeu_ps(second + 4, _mm_movehl_ps(zero, sc[pair]));
+				_mm_storeu_ps(second + 8, column2);
+				_mm_storeu_ps(second + 12, _mm_movehl_ps(zeroOne, xy[pair]));
+			}
+		}
+#endif
+
+		BuildInstanceTransformsScalar(x + i, y + i, angle + i, out + i, count - i);
+	}
+}
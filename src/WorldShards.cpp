@@ -0,0 +1,166 @@
+#include <pch.h>
+#include <NetworkingPhysics.h>
+#include <WorldShards.h>
+#include <JobSystem.h>
+#include <Scene.h>
+#include <BodyPool.h>
+
+namespace NetPhysics {
+	namespace {
+		void SetGhostFilter(b2Body* const body, const bool ghost) {
+			b2Filter filter;
+			if (ghost) {
+				filter.categoryBits = SHARD_GHOST_CATEGORY;
+				filter.maskBits = static_cast<uint16_t>(~SHARD_GHOST_CATEGORY);
+			}
+			body->GetFixtureList()->SetFilterData(filter);
+		}
+
+		// Copies the state of the body owning the slot, including whether it sleeps
+		void CopyBodyState(b2Body* const to, const b2Body* const from) {
+			to->SetTransform(from->GetPosition(), from->GetAngle());
+			to->SetLinearVelocity(from->GetLinearVelocity());
+			to->SetAngularVelocity(from->GetAngularVelocity());
+			to->SetAwake(from->IsAwake());
+			if (!to->IsEnabled()) to->SetEnabled(true);
+		}
+
+		b2Body* CreateShardGhost(WorldShard& shard, const b2Body* const owner) {
+			b2BodyDef ghostDef;
+			ghostDef.type = b2_dynamicBody;
+			ghostDef.enabled = false;
+
+			b2Body* ghost = CreateTriangleBody(*shard.World, ghostDef, BodyMaterial(owner));
+			SetGhostFilter(ghost, true);
+			return ghost;
+		}
+	}
+
+	void CreateWorldShards(const int count, const b2Vec2& gravity) {
+		Shards.resize(std::max(1, count));
+
+		for (WorldShard& shard : Shards) {
+			shard.World = std::make_unique<b2World>(gravity);
+			CreateSceneStatics(*shard.World, shard.Statics);
+		}
+	}
+
+	void CreatePhysicsTriangles() {
+
+		// Define physics body
+		b2BodyDef dynamicBodyDef;
+		dynamicBodyDef.type = b2_dynamicBody;
+
+		const std::span<const SceneBody> bodies = ActiveScene.Bodies;
+
+		// Create triangle objects in the shard that owns their starting position, slots the scene leaves empty start out pooled
+		for (int i = 0; i < COUNT_TRIANGLES; i++) {
+			const bool inScene = i < static_cast<int>(bodies.size());
+			const auto& [SpatialData, PhysicsData] = inScene ? bodies[i].State : ParkedBody();
+
+			dynamicBodyDef.position.Set(SpatialData[0], SpatialData[1]);
+			dynamicBodyDef.angle = SpatialData[2];
+			dynamicBodyDef.linearVelocity.Set(PhysicsData[0], PhysicsData[1]);
+			dynamicBodyDef.angularVelocity = PhysicsData[2];
+			dynamicBodyDef.enabled = inScene;
+
+			TriangleShards[i] = ShardForPosition(dynamicBodyDef.position.x);
+			Triangles[i] = CreateTriangleBody(*Shards[TriangleShards[i]].World, dynamicBodyDef,
+				inScene ? ActiveScene.Materials[bodies[i].Material] : DEFAULT_BODY_MATERIAL);
+		}
+	}
+
+	SceneMaterial BodyMaterial(const b2Body* const body) {
+		const b2Fixture* fixture = body->GetFixtureList();
+		return SceneMaterial { fixture->GetDensity(), fixture->GetFriction(), fixture->GetRestitution() };
+	}
+
+	void DestroyWorldShards() {
+		Shards.clear();
+		std::ranges::fill(Triangles, nullptr);
+	}
+
+	int ShardForPosition(const float x) {
+		const int count = static_cast<int>(Shards.size());
+		const float width = (ARENA_MAX_X - ARENA_MIN_X) / static_cast<float>(count);
+		const int index = static_cast<int>(std::floor((x - ARENA_MIN_X) / width));
+		return std::clamp(index, 0, count - 1);
+	}
+
+	void SetShardGravity(const b2Vec2& gravity) {
+		for (const WorldShard& shard : Shards) {
+			shard.World->SetGravity(gravity);
+		}
+	}
+
+	void SyncShardGhosts() {
+		if (Shards.size() < 2) return;
+
+		const float width = (ARENA_MAX_X - ARENA_MIN_X) / static_cast<float>(Shards.size());
+
+		for (int i = 0; i < COUNT_TRIANGLES; i++) {
+			const b2Body* body = Triangles[i];
+			const int owner = TriangleShards[i];
+			const float x = body->GetPosition().x;
+
+			// Pooled bodies are parked and need no ghosts
+			const bool live = TestBodyBit(BodiesLive, i);
+			const float ownerMin = ARENA_MIN_X + width * static_cast<float>(owner);
+			const bool nearLeft = live && owner > 0 && x - ownerMin < SHARD_GHOST_MARGIN;
+			const bool nearRight = live && owner + 1 < static_cast<int>(Shards.size()) && ownerMin + width - x < SHARD_GHOST_MARGIN;
+
+			for (int s = 0; s < static_cast<int>(Shards.size()); s++) {
+				b2Body*& ghost = Shards[s].Ghosts[i];
+				const bool wanted = (s == owner - 1 && nearLeft) || (s == owner + 1 && nearRight);
+
+				if (!wanted) {
+					if (ghost && ghost->IsEnabled()) ghost->SetEnabled(false);
+					continue;
+				}
+
+				if (!ghost) ghost = CreateShardGhost(Shards[s], body);
+				CopyBodyState(ghost, body);
+			}
+		}
+	}
+
+	void MigrateShardBodies() {
+		if (Shards.size() < 2) return;
+
+		// Serial and in index order so the result does not depend on scheduling
+		for (int i = 0; i < COUNT_TRIANGLES; i++) {
+			// A pooled body is parked, it moves shards once it is spawned again
+			if (!TestBodyBit(BodiesLive, i)) continue;
+
+			b2Body* body = Triangles[i];
+			const int source = TriangleShards[i];
+			const int target = ShardForPosition(body->GetPosition().x);
+
+			if (target == source) continue;
+
+			// The ghost was stepped as the other world saw it, the owner's result is the one that counts
+			b2Body* owner = Shards[target].Ghosts[i];
+			if (!owner) owner = CreateShardGhost(Shards[target], body);
+			CopyBodyState(owner, body);
+			SetGhostFilter(owner, false);
+			SetGhostFilter(body, true);
+
+			Shards[target].Ghosts[i] = nullptr;
+			Shards[source].Ghosts[i] = body;
+			Triangles[i] = owner;
+			TriangleShards[i] = target;
+		}
+	}
+
+	void StepWorldShards(const float timeStep, const int velocityIterations, const int positionIterations) {
+		SyncShardGhosts();
+
+		ParallelFor(static_cast<int>(Shards.size()), 1, [=](const int begin, const int end) {
+			for (int s = begin; s < end; s++) {
+				Shards[s].World->Step(timeStep, velocityIterations, positionIterations);
+			}
+		});
+
+		MigrateShardBodies();
+	}
+}
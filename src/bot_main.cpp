@@ -0,0 +1,135 @@
+#include <pch.h>
+#include <NetworkingPhysics.h>
+#include <Protocol.h>
+#include <NetworkShim.h>
+#include <ReliableChannel.h>
+#include <Keyframe.h>
+#include <Compression.h>
+#include <Netcode.h>
+#include <DeadReckoning.h>
+#include <BodyPool.h>
+#include <BotClient.h>
+#include <Config.h>
+#include <Benchmarks.h>
+
+// Headless load generator: NetworkingPhysicsBot -bots N -threads T -duration S -interval MS -report file.csv,
+// plus the -config, -address, -port and -net-* network condition options of the main executable. -bench-protocol measures snapshot
+// encode and decode throughput, -bench-join the time for a 10k body keyframe join, -bench-broadcast the
+// snapshot broadcast time over 1 to 16 broadcast workers and 100 to 5000 clients, -bench-compression
+// the snapshot compression ratio and cost, -bench-reckoning the bodies sent and client error under dead
+// reckoning, -bench-step the step time of the default scene on 1 to 16 threads with one shard per thread
+// or -shards N, -bench-transforms the SSE2 instance transforms against linmath, -bench-spawning the
+// throughput of pooled spawns and despawns at 10k bodies per tick and -bench-reset the time to reset
+// 10k bodies, instead of connecting. -train-dictionary recording.bin out.dict trains a compression dictionary from snapshots recorded
+// by a server run with -record-snapshots, which bots and clients then load with -dictionary.
+int main(int argc, char* argv[]) {
+	int bots = 100;
+	int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency() / 2));
+	int durationSeconds = 0;
+	int reportIntervalMs = 1000;
+	std::string reportFile;
+	bool configValid = true;
+	int shardCount = 0;
+	bool benchStep = false;
+
+	for (int i = 1; i + 1 < argc; i++) {
+		if (strcmp(argv[i], "-config") == 0 && !NetPhysics::LoadConfigFile(argv[++i], NetPhysics::Config)) return 1;
+	}
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-config") == 0 && i + 1 < argc)
+			i++;
+		else if (NetPhysics::ParseConfigArgument(i, argc, argv, NetPhysics::Config, configValid))
+			continue;
+		else if (strcmp(argv[i], "-bots") == 0 && i + 1 < argc) {
+			if (!NetPhysics::ParseIntFlag(i, argv, 1, 100'000, bots)) configValid = false;
+		}
+		else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc) {
+			if (!NetPhysics::ParseIntFlag(i, argv, 1, 256, threads)) configValid = false;
+		}
+		else if (strcmp(argv[i], "-duration") == 0 && i + 1 < argc) {
+			if (!NetPhysics::ParseIntFlag(i, argv, 0, 86'400, durationSeconds)) configValid = false;
+		}
+		else if (strcmp(argv[i], "-interval") == 0 && i + 1 < argc) {
+			if (!NetPhysics::ParseIntFlag(i, argv, 100, 3'600'000, reportIntervalMs)) configValid = false;
+		}
+		else if (strcmp(argv[i], "-report") == 0 && i + 1 < argc)
+			reportFile = argv[++i];
+		else if (strcmp(argv[i], "-shards") == 0 && i + 1 < argc) {
+			if (!NetPhysics::ParseIntFlag(i, argv, 1, 64, shardCount)) configValid = false;
+		}
+		else if (strcmp(argv[i], "-bench-step") == 0)
+			benchStep = true;
+		else if (strcmp(argv[i], "-bench-protocol") == 0) {
+			NetPhysics::BenchmarkProtocol(100'000);
+			return 0;
+		}
+		else if (strcmp(argv[i], "-bench-join") == 0) {
+			NetPhysics::BenchmarkJoin(10'000);
+			return 0;
+		}
+		else if (strcmp(argv[i], "-bench-broadcast") == 0) {
+			NetPhysics::BenchmarkBroadcast(20);
+			return 0;
+		}
+		else if (strcmp(argv[i], "-bench-compression") == 0) {
+			NetPhysics::BenchmarkCompression();
+			return 0;
+		}
+		else if (strcmp(argv[i], "-bench-reckoning") == 0) {
+			NetPhysics::BenchmarkReckoning();
+			return 0;
+		}
+		else if (strcmp(argv[i], "-bench-transforms") == 0) {
+			NetPhysics::BenchmarkTransforms(10'000, 1'000);
+			return 0;
+		}
+		else if (strcmp(argv[i], "-bench-spawning") == 0) {
+			NetPhysics::BenchmarkBodyPool(10'000, 300);
+			return 0;
+		}
+		else if (strcmp(argv[i], "-bench-reset") == 0) {
+			NetPhysics::BenchmarkReset(10'000, 10);
+			return 0;
+		}
+		else if (strcmp(argv[i], "-train-dictionary") == 0 && i + 2 < argc)
+			return NetPhysics::TrainCompressionDictionary(argv[i + 1], argv[i + 2]) ? 0 : 1;
+		else if (strcmp(argv[i], "-dictionary") == 0 && i + 1 < argc) {
+			if (!NetPhysics::LoadCompressionDictionary(argv[++i])) return 1;
+		}
+		else if (!NetPhysics::ParseNetworkShimArgument(i, argc, argv)) {
+			std::cerr << argv[i] << ": unknown flag or missing value\n";
+			return 1;
+		}
+	}
+
+	if (!configValid) return 1;
+
+	// Run once all flags are read, so -shards and the solver iterations apply wherever they appear
+	if (benchStep) {
+		NetPhysics::BenchmarkStep(300, shardCount);
+		return 0;
+	}
+
+	if (NetPhysics::WSAInit() != 0) return 1;
+
+	const std::wstring address = NetPhysics::ConfigAddress(NetPhysics::Config);
+	const std::wstring port = NetPhysics::ConfigPort(NetPhysics::Config);
+
+	std::atomic_flag botsRunning {};
+
+	auto exitCode = std::async(std::launch::async, NetPhysics::RunBotClients, std::cref(botsRunning),
+		bots, threads, reportIntervalMs, std::cref(reportFile), address.c_str(), port.c_str());
+
+	// Without a duration the bots run until Enter is pressed
+	if (durationSeconds > 0)
+		std::this_thread::sleep_for(std::chrono::seconds(durationSeconds));
+	else
+		std::cin.get();
+
+	botsRunning.test_and_set();
+	const int rc = exitCode.get();
+
+	WSACleanup();
+	return rc == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -1,56 +1,85 @@
 #include <pch.h>
 #include <NetworkingPhysics.h>
+#include <Protocol.h>
+#include <NetworkShim.h>
+#include <ReliableChannel.h>
+#include <Keyframe.h>
+#include <Compression.h>
 #include <Netcode.h>
+#include <LagCompensation.h>
+#include <DeadReckoning.h>
+#include <BodyPool.h>
+#include <Scene.h>
+#include <JobSystem.h>
+#include <WorldShards.h>
+#include <Transforms.h>
+#include <InstanceStream.h>
+#include <Simulation.h>
+#include <Profiler.h>
+#include <Metrics.h>
+#include <MemoryAccounting.h>
+#include <ShaderCache.h>
+#include <Config.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 
-int main(int argc, char* argv[]) {
-	if (argc < 2) return 1;
-
-	std::atomic_flag networkRunning {};
-	std::atomic_flag timerRunning {};
-	std::future<int> networkExitCode;
-	std::future<void> timer;
-
-	bool isServer = false;
-
-	if (strcmp(argv[1], "-client") == 0)
-		networkExitCode = std::async(NetPhysics::ConnectToServer, std::ref(networkRunning));
-	else if (strcmp(argv[1], "-server") == 0)
-	{
-		isServer = true;
-		networkExitCode = std::async(NetPhysics::ListenForClients, std::ref(networkRunning));
-		timer = std::async(NetPhysics::TimedSend, 1, std::ref(timerRunning));
-	}
-	else
-		return 1;
-
+// Opens the window while the world is built on a worker, waits for the world and runs the render loop until
+// the window is closed, then releases the GL resources. Returns false if the shader program failed to build.
+bool RunWindow(const bool isServer, const NetPhysics::InstanceLayout instanceLayout, std::future<void>& worldBuild, const bool startupReport) {
+	int64_t phaseStart = NetPhysics::StartupElapsedNs();
 	GLFWwindow* window = NetPhysics::InitWindow();
+	phaseStart = NetPhysics::EndStartupPhase("Window", phaseStart);
+
 	gladLoadGL(glfwGetProcAddress);
+	phaseStart = NetPhysics::EndStartupPhase("GL loader", phaseStart);
+
 	NetPhysics::InitImGui(window);
 	const ImGuiIO& io = ImGui::GetIO(); (void)io;
-
-	const GLuint program = NetPhysics::GenerateShaderProgram("triangle");
+	phaseStart = NetPhysics::EndStartupPhase("ImGui", phaseStart);
+
+	const auto closeWindow = [window] {
+		ImGui_ImplOpenGL3_Shutdown();
+		ImGui_ImplGlfw_Shutdown();
+		ImGui::DestroyContext();
+
+		glfwDestroyWindow(window);
+		glfwTerminate();
+	};
+
+	const GLuint program = instanceLayout == NetPhysics::InstanceLayout::Compact
+		? NetPhysics::GenerateShaderProgram("triangle")
+		: NetPhysics::GenerateShaderProgram("triangle_matrix", "triangle");
+	phaseStart = NetPhysics::EndStartupPhase(NetPhysics::ShaderProgramCached ? "Shaders (cached)" : "Shaders", phaseStart);
+
+	// The compile or link error was already printed. The world still finishes building, so main shuts down as usual.
+	if (program == 0) {
+		worldBuild.get();
+		closeWindow();
+		return false;
+	}
 
 	const GLint v_location = glGetUniformLocation(program, "ViewMatrix");
 	const GLint p_location = glGetUniformLocation(program, "ProjMatrix");
 
-	GLuint vertexBuffer, transformBuffer, indexBuffer, vertexArray;
-	NetPhysics::GenerateTriangleBuffers(program, vertexBuffer, transformBuffer, indexBuffer, vertexArray);
-
-	const auto world = std::make_unique<b2World>(b2Vec2(0, -9.81f));
+	NetPhysics::InstanceStream instanceStream;
+	NetPhysics::CreateInstanceStream(instanceStream, static_cast<GLsizeiptr>(NetPhysics::InstanceDataSize(instanceLayout)));
 
-	NetPhysics::CreateWorldBounds(world);
-	NetPhysics::CreatePhysicsTriangles(world);
+	GLuint vertexBuffer, indexBuffer, vertexArray;
+	NetPhysics::GenerateTriangleBuffers(program, vertexBuffer, indexBuffer, vertexArray, instanceStream, instanceLayout);
+	phaseStart = NetPhysics::EndStartupPhase("Buffers", phaseStart);
 
-	NetPhysics::ObjectsInitialized.test_and_set(std::memory_order::acquire);
+	worldBuild.get();
+	phaseStart = NetPhysics::EndStartupPhase("World wait", phaseStart);
+	bool firstFrame = true;
 
-	const auto rate = glfwGetVideoMode(glfwGetPrimaryMonitor())->refreshRate;
-
-	float gravityModifier = 0;
 	float clearColor[3] = { 0.2f, 0.2f, 0.2f };
 
+	bool dragging = false;
+	float dragStart[2] = {};
+
 	while (!glfwWindowShouldClose(window)) {
+		PROFILE_SCOPE(Frame);
+
 		glfwPollEvents();
 
 		ImGui_ImplOpenGL3_NewFrame();
@@ -59,17 +88,38 @@ int main(int argc, char* argv[]) {
 
 		ImGui::Begin("Test Window");
 
-		ImGui::SliderFloat("Gravity factor", &gravityModifier, 0, 1);
+		// Clients follow the gravity the server sends, so the slider starts from the current value
+		float gravityModifier = NetPhysics::GravityModifier.load(std::memory_order::relaxed);
+		if (ImGui::SliderFloat("Gravity factor", &gravityModifier, 0, 1))
+			NetPhysics::GravityModifier.store(gravityModifier, std::memory_order::relaxed);
 		ImGui::ColorPicker3("Clear Color", clearColor);
 
+		// Spawning is up to the server, clients follow its body events
+		ImGui::Text("Bodies: %d of %d", NetPhysics::LiveBodyCount.load(std::memory_order::relaxed), NetPhysics::COUNT_TRIANGLES);
+		if (isServer) {
+			if (ImGui::Button("Spawn"))
+				NetPhysics::SpawnRequests.fetch_add(NetPhysics::BODY_SPAWN_BATCH, std::memory_order::release);
+			ImGui::SameLine();
+			if (ImGui::Button("Despawn"))
+				NetPhysics::DespawnRequests.fetch_add(NetPhysics::BODY_SPAWN_BATCH, std::memory_order::release);
+		}
+
 		ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / io.Framerate, io.Framerate);
+		ImGui::Text("Simulation tick %.3f ms at %d Hz", NetPhysics::LastTickMs.load(std::memory_order::relaxed),
+			NetPhysics::SIMULATION_TICK_RATE);
+		ImGui::Text("Last reset %.3f ms", NetPhysics::LastResetMs.load(std::memory_order::relaxed));
+		ImGui::Text("Instance upload: %s, %.3f ms waiting on GPU", instanceStream.Persistent ? "persistent"
+			: instanceStream.Staged ? "staged" : "orphaning",
+			instanceStream.FenceWaitMs);
+		ImGui::Text("Shader program: %s", NetPhysics::ShaderProgramCached ? "cached binary" : "compiled");
 
 		ImGui::End();
 
-		world->SetGravity({ 0, -9.81f * gravityModifier });
+		NetPhysics::DrawProfilerWindow();
+		NetPhysics::DrawNetworkShimWindow();
 
 		int width, height;
-		mat4x4 m, v, p;
+		mat4x4 v, p;
 
 		glfwGetFramebufferSize(window, &width, &height);
 		const float ratio = static_cast<float>(width) / static_cast<float>(height);
@@ -78,39 +128,55 @@ int main(int argc, char* argv[]) {
 		glClearColor(clearColor[0], clearColor[1], clearColor[2], 1);
 		glClear(GL_COLOR_BUFFER_BIT);
 
-		if (isServer)
-			world->Step(1.0f / static_cast<float>(rate), 20, 10);
-		else if (NetPhysics::TriDataMutex.try_lock()) {
-			world->Step(1.0f / static_cast<float>(rate), 20, 10);
-			NetPhysics::TriDataMutex.unlock();
-		}
-
-		if (isServer)
-			NetPhysics::CollectTriangleData();
-
 		// Set camera
 		mat4x4_identity(v);
 		mat4x4_translate_in_place(v, 0, 0, 0);
 		mat4x4_invert(v, v);
 
-		constexpr float zoom = 7;
+		constexpr float zoom = NetPhysics::ARENA_HALF_EXTENT;
 
 		// Projection
 		mat4x4_ortho(p, -ratio * zoom, ratio * zoom, -zoom, zoom, 1.0f, -1.0f);
 
-		for (int i = 0; i < NetPhysics::COUNT_TRIANGLES; i++) {
-			mat4x4_identity(m);
-			auto& pos = NetPhysics::Triangles[i]->GetPosition();
-			mat4x4_translate_in_place(m, pos.x, pos.y, 0);
-			mat4x4_rotate_Z(m, m, NetPhysics::Triangles[i]->GetAngle());
-			mat4x4_dup(NetPhysics::TriangleTransforms[i], m);
+		// Dragging across the scene pushes the body under the press along the drag
+		int windowWidth, windowHeight;
+		glfwGetWindowSize(window, &windowWidth, &windowHeight);
+
+		if (windowWidth > 0 && windowHeight > 0) {
+			double cursorX, cursorY;
+			glfwGetCursorPos(window, &cursorX, &cursorY);
+
+			const float worldX = (static_cast<float>(cursorX / windowWidth) * 2.0f - 1.0f) * ratio * zoom;
+			const float worldY = (1.0f - static_cast<float>(cursorY / windowHeight) * 2.0f) * zoom;
+			const bool pressed = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+
+			if (pressed && !dragging && !io.WantCaptureMouse) {
+				dragging = true;
+				dragStart[0] = worldX;
+				dragStart[1] = worldY;
+			}
+			else if (!pressed && dragging) {
+				dragging = false;
+				NetPhysics::SubmitInteraction(isServer, dragStart[0], dragStart[1],
+					(worldX - dragStart[0]) * NetPhysics::INTERACTION_IMPULSE_PER_METER,
+					(worldY - dragStart[1]) * NetPhysics::INTERACTION_IMPULSE_PER_METER);
+			}
 		}
 
+		// Write this frame's instance data straight into the mapped instance buffer
+		void* const instances = NetPhysics::BeginInstanceFrame(instanceStream);
+
+		// Display one tick in the past so the two latest simulation states bracket the render time
+		constexpr double interpolationDelay = 1.0 / NetPhysics::SIMULATION_TICK_RATE;
+		NetPhysics::WriteInterpolatedInstances(NetPhysics::SimulationTime() - interpolationDelay, instanceLayout, instances);
+
+		const GLintptr instanceOffset = NetPhysics::EndInstanceFrame(instanceStream);
+
 		glUseProgram(program);
 		glBindVertexArray(vertexArray);
 
-		glBindBuffer(GL_ARRAY_BUFFER, transformBuffer);
-		glBufferSubData(GL_ARRAY_BUFFER, 0, NetPhysics::COUNT_TRIANGLES * sizeof(mat4x4), NetPhysics::TriangleTransforms);
+		glBindBuffer(GL_ARRAY_BUFFER, instanceStream.Buffer);
+		NetPhysics::SetInstanceAttributes(program, instanceLayout, instanceOffset);
 
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
 
@@ -119,24 +185,215 @@ int main(int argc, char* argv[]) {
 
 		glDrawElementsInstanced(GL_TRIANGLES, 3, GL_UNSIGNED_INT, nullptr, NetPhysics::COUNT_TRIANGLES);
 
+		NetPhysics::FenceInstanceFrame(instanceStream);
+
 		ImGui::Render();
 		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
 		glfwSwapBuffers(window);
+
+		if (firstFrame) {
+			firstFrame = false;
+			NetPhysics::EndStartupPhase("First frame", phaseStart);
+			if (startupReport) NetPhysics::PrintStartupTimeline();
+		}
 	}
 
+	NetPhysics::DestroyInstanceStream(instanceStream);
+	closeWindow();
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 2) return 1;
+
+	// Compiles a text scene into the binary form that loads by mapping the file
+	if (strcmp(argv[1], "-compile-scene") == 0)
+		return argc == 4 && NetPhysics::CompileSceneFile(argv[2], argv[3]) ? 0 : 1;
+
+	std::atomic_flag networkRunning {};
+	std::atomic_flag timerRunning {};
+	std::atomic_flag simulationRunning {};
+	std::atomic_flag metricsRunning {};
+	std::future<int> networkExitCode;
+	std::future<void> timer;
+	std::future<void> simulation;
+	std::future<int> metrics;
+
+	bool isServer = false;
+	int shardCount = 1;
+	auto instanceLayout = NetPhysics::InstanceLayout::Compact;
+	std::string traceFile;
+	std::wstring metricsPort;
+	std::string metricsFile;
+	bool extrapolate = false;
+	bool thin = false;
+	bool headless = false;
+	bool memoryReport = false;
+	bool startupReport = false;
+	std::string sceneFile;
+	bool configValid = true;
+
+	// The config file is read first so that flags override it wherever they appear
+	for (int i = 2; i + 1 < argc; i++) {
+		if (strcmp(argv[i], "-config") == 0 && !NetPhysics::LoadConfigFile(argv[++i], NetPhysics::Config)) return 1;
+	}
+
+	for (int i = 2; i < argc; i++) {
+		if (strcmp(argv[i], "-config") == 0 && i + 1 < argc)
+			i++;
+		else if (NetPhysics::ParseConfigArgument(i, argc, argv, NetPhysics::Config, configValid))
+			continue;
+		else if (strcmp(argv[i], "-shards") == 0 && i + 1 < argc) {
+			if (!NetPhysics::ParseIntFlag(i, argv, 1, 64, shardCount)) configValid = false;
+		}
+		else if (strcmp(argv[i], "-matrix-instances") == 0)
+			instanceLayout = NetPhysics::InstanceLayout::Matrix;
+		else if (strcmp(argv[i], "-trace") == 0 && i + 1 < argc)
+			traceFile = argv[++i];
+		else if (strcmp(argv[i], "-metrics-port") == 0 && i + 1 < argc) {
+			int port = 0;
+			if (NetPhysics::ParseIntFlag(i, argv, 1, 65535, port)) metricsPort = std::to_wstring(port);
+			else configValid = false;
+		}
+		else if (strcmp(argv[i], "-metrics-file") == 0 && i + 1 < argc)
+			metricsFile = argv[++i];
+		else if (strcmp(argv[i], "-compress") == 0)
+			NetPhysics::CompressionEnabled = true;
+		else if (strcmp(argv[i], "-dictionary") == 0 && i + 1 < argc) {
+			if (!NetPhysics::LoadCompressionDictionary(argv[++i])) return 1;
+		}
+		else if (strcmp(argv[i], "-extrapolate") == 0)
+			extrapolate = true;
+		else if (strcmp(argv[i], "-thin") == 0)
+			thin = true;
+		else if (strcmp(argv[i], "-headless") == 0)
+			headless = true;
+		else if (strcmp(argv[i], "-memory-report") == 0)
+			memoryReport = true;
+		else if (strcmp(argv[i], "-startup-report") == 0)
+			startupReport = true;
+		else if (strcmp(argv[i], "-no-shader-cache") == 0)
+			NetPhysics::ShaderCacheEnabled = false;
+		else if (strcmp(argv[i], "-scene") == 0 && i + 1 < argc)
+			sceneFile = argv[++i];
+		else if (strcmp(argv[i], "-reckon-tolerance") == 0 && i + 1 < argc) {
+			if (!NetPhysics::ParseFloatFlag(i, argv, 0.0f, 100.0f, NetPhysics::ReckoningTolerance)) configValid = false;
+		}
+		else if (strcmp(argv[i], "-record-snapshots") == 0 && i + 1 < argc) {
+			if (!NetPhysics::OpenSnapshotRecording(argv[++i])) return 1;
+		}
+		else if (!NetPhysics::ParseNetworkShimArgument(i, argc, argv)) {
+			std::cerr << argv[i] << ": unknown flag or missing value\n";
+			return 1;
+		}
+	}
+
+	if (!configValid) return 1;
+
+	// Server and clients must load the same scene, the keyframe carries its hash
+	int64_t phaseStart = NetPhysics::StartupElapsedNs();
+
+	if (sceneFile.empty())
+		NetPhysics::BuildDefaultScene(NetPhysics::ActiveScene);
+	else if (!NetPhysics::LoadScene(sceneFile, NetPhysics::ActiveScene))
+		return 1;
+
+	// Servers may start with part of the scene pooled, clients take the live slots from the snapshots
+	NetPhysics::CaptureInitialState(strcmp(argv[1], "-server") == 0 ? NetPhysics::Config.Bodies : NetPhysics::COUNT_TRIANGLES);
+	phaseStart = NetPhysics::EndStartupPhase("Scene", phaseStart);
+
+	if (strcmp(argv[1], "-client") == 0) {
+		NetPhysics::ExtrapolationEnabled = extrapolate;
+		NetPhysics::ThinClient = thin;
+		networkExitCode = std::async(NetPhysics::ConnectToServer, std::ref(networkRunning));
+	}
+	else if (strcmp(argv[1], "-server") == 0)
+	{
+		isServer = true;
+		NetPhysics::Headless = headless;
+		NetPhysics::StartBroadcastWorkers(static_cast<unsigned>(NetPhysics::Config.BroadcastWorkers));
+		networkExitCode = std::async(NetPhysics::ListenForClients, std::ref(networkRunning));
+		timer = std::async(NetPhysics::TimedSend, NetPhysics::Config.SendIntervalMs * 1'000'000LL, std::ref(timerRunning));
+
+		if (!metricsPort.empty() || !metricsFile.empty())
+			metrics = std::async(std::launch::async, NetPhysics::RunMetricsExporter, std::ref(metricsRunning), metricsPort, metricsFile, 1000);
+	}
+	else
+		return 1;
+
+	if (!traceFile.empty())
+		NetPhysics::TraceEnabled.test_and_set(std::memory_order::relaxed);
+
+	NetPhysics::StartJobWorkers(std::max(1u, std::thread::hardware_concurrency()) - 1);
+	phaseStart = NetPhysics::EndStartupPhase("Threads", phaseStart);
+
+	// Nothing in the world depends on the window, so it is built on a worker while the main thread opens the window
+	std::future<void> worldBuild = std::async(std::launch::async, [&] {
+		int64_t worldStart = NetPhysics::StartupElapsedNs();
+
+		// Thin clients display the received state and never build a world
+		if (!NetPhysics::ThinClient) {
+			NetPhysics::CreateWorldShards(shardCount, b2Vec2(0, NetPhysics::Config.Gravity));
+			NetPhysics::CreatePhysicsTriangles();
+
+			if (NetPhysics::ExtrapolationEnabled)
+				NetPhysics::SeedExtrapolation();
+		}
+
+		NetPhysics::InitBodyPool(NetPhysics::InitialBodyCount);
+		worldStart = NetPhysics::EndStartupPhase("World", worldStart);
+
+		// Two published states give the render thread something to interpolate from the first frame
+		if (!NetPhysics::Headless) {
+			NetPhysics::PublishRenderState(NetPhysics::SimulationTime());
+			NetPhysics::PublishRenderState(NetPhysics::SimulationTime());
+		}
+
+		NetPhysics::ObjectsInitialized.test_and_set(std::memory_order::acquire);
+
+		simulation = std::async(std::launch::async, NetPhysics::SimulationLoop, std::ref(simulationRunning), isServer);
+		NetPhysics::EndStartupPhase("Simulation", worldStart);
+	});
+
+	bool shadersBuilt = true;
+
+	if (NetPhysics::Headless) {
+		worldBuild.get();
+		if (startupReport) NetPhysics::PrintStartupTimeline();
+
+		std::cout << "Running headless with " << NetPhysics::COUNT_TRIANGLES << " bodies, press Enter to stop\n";
+		std::cin.get();
+	}
+	else
+		shadersBuilt = RunWindow(isServer, instanceLayout, worldBuild, startupReport);
+
+	simulationRunning.test_and_set(std::memory_order::acquire);
+	simulation.get();
+
+	// Taken with the simulation stopped and the world still alive, so Box2D's live counts are stable
+	if (memoryReport)
+		NetPhysics::PrintMemoryReport(isServer);
+
 	networkRunning.test_and_set(std::memory_order::acquire);
 	timerRunning.test_and_set(std::memory_order::acquire);
 	std::cout << "Networking thread exited with code: " << networkExitCode.get() << "\n";
-	if (isServer)
+	if (isServer) {
 		timer.get();
+		NetPhysics::StopBroadcastWorkers();
+		NetPhysics::CloseSnapshotRecording();
+	}
+
+	metricsRunning.test_and_set(std::memory_order::acquire);
+	if (metrics.valid())
+		metrics.get();
 
-	ImGui_ImplOpenGL3_Shutdown();
-	ImGui_ImplGlfw_Shutdown();
-	ImGui::DestroyContext();
+	if (!traceFile.empty())
+		NetPhysics::WriteChromeTrace(traceFile);
 
-	glfwDestroyWindow(window);
-	glfwTerminate();
+	NetPhysics::DestroyWorldShards();
+	NetPhysics::StopJobWorkers();
+	NetPhysics::UnloadScene(NetPhysics::ActiveScene);
 
-	return 0;
+	return shadersBuilt ? 0 : 1;
 }
\ No newline at end of file